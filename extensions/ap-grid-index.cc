@@ -0,0 +1,204 @@
+/* -*- Mode:C++; c-file-style:"gnu"; -*- */
+/*
+ *
+ * Copyright (c) 2014 Waseda University, Sato Laboratory
+ * Author: Jairo Eduardo Lopez <jairo@ruri.waseda.jp>
+ *
+ *  ap-grid-index.cc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  ap-grid-index.cc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero Public License
+ *  along with ap-grid-index.cc.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ap-grid-index.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <ns3-dev/ns3/assert.h>
+
+namespace ns3 {
+
+ApGridIndex::ApGridIndex ()
+	: m_minX (0)
+	, m_minY (0)
+	, m_cellSize (1)
+	, m_cellsX (0)
+	, m_cellsY (0)
+{
+}
+
+uint32_t
+ApGridIndex::Add (const std::string &ssid, Vector pos)
+{
+	NS_ASSERT_MSG (m_cells.empty (), "APs added after Build");
+
+	m_ssids.push_back (ssid);
+	m_positions.push_back (pos);
+	return m_positions.size () - 1;
+}
+
+void
+ApGridIndex::Build (double cellSize)
+{
+	NS_ASSERT (!m_positions.empty ());
+
+	double maxX = m_positions[0].x;
+	double maxY = m_positions[0].y;
+	m_minX = maxX;
+	m_minY = maxY;
+
+	for (uint32_t i = 1; i < m_positions.size (); i++)
+	{
+		m_minX = std::min (m_minX, m_positions[i].x);
+		m_minY = std::min (m_minY, m_positions[i].y);
+		maxX = std::max (maxX, m_positions[i].x);
+		maxY = std::max (maxY, m_positions[i].y);
+	}
+
+	double width = maxX - m_minX;
+	double height = maxY - m_minY;
+
+	if (cellSize <= 0)
+	{
+		// About one AP per cell, APs on a line give a line of cells
+		if (width > 0 && height > 0)
+			cellSize = std::sqrt (width * height / m_positions.size ());
+		else
+			cellSize = std::max (width, height) / m_positions.size ();
+	}
+
+	m_cellSize = cellSize > 0 ? cellSize : 1;
+	m_cellsX = (int32_t) (width / m_cellSize) + 1;
+	m_cellsY = (int32_t) (height / m_cellSize) + 1;
+
+	m_cells.clear ();
+	m_cells.resize (m_cellsX * m_cellsY);
+
+	for (uint32_t i = 0; i < m_positions.size (); i++)
+		m_cells[GetCellY (m_positions[i].y) * m_cellsX + GetCellX (m_positions[i].x)].push_back (i);
+}
+
+uint32_t
+ApGridIndex::GetN () const
+{
+	return m_positions.size ();
+}
+
+const std::string &
+ApGridIndex::GetSsid (uint32_t id) const
+{
+	return m_ssids[id];
+}
+
+Vector
+ApGridIndex::GetPosition (uint32_t id) const
+{
+	return m_positions[id];
+}
+
+uint32_t
+ApGridIndex::Nearest (Vector pos, double *distance) const
+{
+	std::vector<uint32_t> ids;
+	KNearest (pos, 1, ids);
+
+	if (distance != 0)
+		*distance = std::sqrt (m_best[0].first);
+
+	return ids[0];
+}
+
+void
+ApGridIndex::KNearest (Vector pos, uint32_t k, std::vector<uint32_t> &ids) const
+{
+	NS_ASSERT_MSG (!m_cells.empty (), "Query before Build");
+
+	k = std::min<uint32_t> (k, m_positions.size ());
+	ids.clear ();
+	m_best.clear ();
+
+	if (k == 0)
+		return;
+
+	int32_t cx = std::max (0, std::min (m_cellsX - 1, GetCellX (pos.x)));
+	int32_t cy = std::max (0, std::min (m_cellsY - 1, GetCellY (pos.y)));
+
+	for (int32_t ring = 0; ; ring++)
+	{
+		int32_t x0 = cx - ring;
+		int32_t x1 = cx + ring;
+		int32_t y0 = cy - ring;
+		int32_t y1 = cy + ring;
+
+		for (int32_t y = std::max (0, y0); y <= std::min (m_cellsY - 1, y1); y++)
+		{
+			// Only the border of the ring, the inside was scanned already
+			int32_t step = (y == y0 || y == y1) ? 1 : x1 - x0;
+
+			for (int32_t x = x0; x <= x1; x += std::max (1, step))
+			{
+				if (x < 0 || x >= m_cellsX)
+					continue;
+
+				const std::vector<uint32_t> &cell = m_cells[y * m_cellsX + x];
+
+				for (uint32_t i = 0; i < cell.size (); i++)
+				{
+					const Vector &ap = m_positions[cell[i]];
+					double dx = ap.x - pos.x;
+					double dy = ap.y - pos.y;
+					double dz = ap.z - pos.z;
+					Candidate c (dx * dx + dy * dy + dz * dz, cell[i]);
+
+					if (m_best.size () == k && !(c < m_best.back ()))
+						continue;
+
+					if (m_best.size () == k)
+						m_best.pop_back ();
+
+					m_best.insert (std::upper_bound (m_best.begin (), m_best.end (), c), c);
+				}
+			}
+		}
+
+		if (x0 <= 0 && y0 <= 0 && x1 >= m_cellsX - 1 && y1 >= m_cellsY - 1)
+			break;
+
+		if (m_best.size () == k)
+		{
+			// Anything outside the scanned square is at least this far
+			double bound = std::min (std::min (pos.x - (m_minX + x0 * m_cellSize),
+							(m_minX + (x1 + 1) * m_cellSize) - pos.x),
+						std::min (pos.y - (m_minY + y0 * m_cellSize),
+							(m_minY + (y1 + 1) * m_cellSize) - pos.y));
+
+			if (bound > 0 && m_best.back ().first < bound * bound)
+				break;
+		}
+	}
+
+	for (uint32_t i = 0; i < m_best.size (); i++)
+		ids.push_back (m_best[i].second);
+}
+
+int32_t
+ApGridIndex::GetCellX (double x) const
+{
+	return (int32_t) std::floor ((x - m_minX) / m_cellSize);
+}
+
+int32_t
+ApGridIndex::GetCellY (double y) const
+{
+	return (int32_t) std::floor ((y - m_minY) / m_cellSize);
+}
+
+} /* namespace ns3 */
@@ -0,0 +1,93 @@
+/* -*- Mode:C++; c-file-style:"gnu"; -*- */
+/*
+ *
+ * Copyright (c) 2014 Waseda University, Sato Laboratory
+ * Author: Jairo Eduardo Lopez <jairo@ruri.waseda.jp>
+ *
+ *  ap-grid-index.h is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  ap-grid-index.h is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero Public License
+ *  along with ap-grid-index.h.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AP_GRID_INDEX_H_
+#define AP_GRID_INDEX_H_
+
+#include <string>
+#include <vector>
+
+#include <ns3-dev/ns3/vector.h>
+
+namespace ns3 {
+
+/**
+ * \brief Uniform grid over fixed access point positions
+ *
+ * Built once after all the APs are added, with cells sized so each holds
+ * about one AP. A query scans rings of cells around the position until no
+ * unscanned cell can hold anything closer, so finding the nearest APs
+ * costs the APs in a few cells instead of all of them. Equal distances go
+ * to the AP added first.
+ */
+class ApGridIndex {
+public:
+	ApGridIndex ();
+
+	// Returns the id of the AP, its position in the order added
+	uint32_t
+	Add (const std::string &ssid, Vector pos);
+
+	// Place the APs in the grid, a cellSize of 0 picks one from their
+	// density
+	void
+	Build (double cellSize = 0);
+
+	uint32_t
+	GetN () const;
+
+	const std::string &
+	GetSsid (uint32_t id) const;
+
+	Vector
+	GetPosition (uint32_t id) const;
+
+	// Id of the AP closest to pos, optionally with its distance
+	uint32_t
+	Nearest (Vector pos, double *distance = 0) const;
+
+	// Replace the contents of ids with the ids of the k APs closest to
+	// pos, nearest first
+	void
+	KNearest (Vector pos, uint32_t k, std::vector<uint32_t> &ids) const;
+
+private:
+	typedef std::pair<double, uint32_t> Candidate;
+
+	int32_t
+	GetCellX (double x) const;
+
+	int32_t
+	GetCellY (double y) const;
+
+	std::vector<std::string> m_ssids;
+	std::vector<Vector> m_positions;
+
+	double m_minX;
+	double m_minY;
+	double m_cellSize;
+	int32_t m_cellsX;
+	int32_t m_cellsY;
+	std::vector<std::vector<uint32_t> > m_cells;
+	mutable std::vector<Candidate> m_best;
+};
+
+} /* namespace ns3 */
+
+#endif /* AP_GRID_INDEX_H_ */
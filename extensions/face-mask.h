@@ -0,0 +1,99 @@
+/* -*- Mode:C++; c-file-style:"gnu"; -*- */
+/*
+ *
+ * Copyright (c) 2014 Waseda University, Sato Laboratory
+ * Author: Jairo Eduardo Lopez <jairo@ruri.waseda.jp>
+ *
+ *  face-mask.h is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  face-mask.h is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero Public License
+ *  along with face-mask.h.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FACE_MASK_H_
+#define FACE_MASK_H_
+
+#include <bitset>
+
+#include <ns3-dev/ns3/ndnSIM/model/ndn-face.h>
+
+#include <ns3-dev/ns3/ptr.h>
+
+namespace ns3 {
+  namespace ndn {
+    namespace fw {
+
+      /**
+       * \brief Fixed width set of Faces of a single node
+       *
+       * Faces are identified by their node relative Id, which L3Protocol
+       * hands out densely from 0. Faces with an Id beyond the width are not
+       * stored; HasOverflow () tells the caller to fall back to a search.
+       */
+      class FaceMask {
+      public:
+	static const uint32_t WIDTH = 128;
+
+	FaceMask ()
+	: m_overflow (false)
+	{
+	}
+
+	void
+	Set (Ptr<const Face> face)
+	{
+	  if (face->GetId () < WIDTH)
+	    m_bits.set (face->GetId ());
+	  else
+	    m_overflow = true;
+	}
+
+	void
+	Reset (Ptr<const Face> face)
+	{
+	  if (face->GetId () < WIDTH)
+	    m_bits.reset (face->GetId ());
+	}
+
+	bool
+	Test (Ptr<const Face> face) const
+	{
+	  return face->GetId () < WIDTH && m_bits.test (face->GetId ());
+	}
+
+	bool
+	HasOverflow () const
+	{
+	  return m_overflow;
+	}
+
+	bool
+	None () const
+	{
+	  return m_bits.none () && !m_overflow;
+	}
+
+	void
+	Clear ()
+	{
+	  m_bits.reset ();
+	  m_overflow = false;
+	}
+
+      private:
+	std::bitset<WIDTH> m_bits;
+	bool m_overflow;
+      };
+
+    } /* namespace fw */
+  } /* namespace ndn */
+} /* namespace ns3 */
+
+#endif /* FACE_MASK_H_ */
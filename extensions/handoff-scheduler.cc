@@ -0,0 +1,221 @@
+/* -*- Mode:C++; c-file-style:"gnu"; -*- */
+/*
+ *
+ * Copyright (c) 2014 Waseda University, Sato Laboratory
+ * Author: Jairo Eduardo Lopez <jairo@ruri.waseda.jp>
+ *
+ *  handoff-scheduler.cc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  handoff-scheduler.cc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero Public License
+ *  along with handoff-scheduler.cc.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "handoff-scheduler.h"
+
+#include <algorithm>
+
+#include <ns3-dev/ns3/log.h>
+#include <ns3-dev/ns3/simulator.h>
+
+NS_LOG_COMPONENT_DEFINE ("HandoffScheduler");
+
+namespace ns3 {
+
+static double
+SquaredDistance (const Vector &a, const Vector &b)
+{
+	double dx = a.x - b.x;
+	double dy = a.y - b.y;
+	double dz = a.z - b.z;
+
+	return dx * dx + dy * dy + dz * dz;
+}
+
+HandoffScheduler::HandoffScheduler (Ptr<MobilityModel> mobility, const ApGridIndex *aps, uint32_t neighbours)
+	: m_mobility (mobility)
+	, m_aps (aps)
+	, m_neighbours (neighbours)
+	, m_running (false)
+	, m_current (0)
+	, m_handoffs (0)
+{
+}
+
+void
+HandoffScheduler::SetHandoffCallback (Callback<void, std::string> handoff)
+{
+	m_handoff = handoff;
+}
+
+void
+HandoffScheduler::SetPrepushCallback (Callback<void, std::string, std::string> prepush, Time lead)
+{
+	m_prepush = prepush;
+	m_lead = lead;
+}
+
+void
+HandoffScheduler::Start ()
+{
+	if (!m_running)
+		m_mobility->TraceConnectWithoutContext ("CourseChange", MakeCallback (&HandoffScheduler::OnCourseChange, this));
+
+	m_running = true;
+	m_current = m_aps->Nearest (m_mobility->GetPosition ());
+
+	if (!m_handoff.IsNull ())
+		m_handoff (m_aps->GetSsid (m_current));
+
+	Reschedule ();
+}
+
+void
+HandoffScheduler::Stop ()
+{
+	if (m_running)
+		m_mobility->TraceDisconnectWithoutContext ("CourseChange", MakeCallback (&HandoffScheduler::OnCourseChange, this));
+
+	m_running = false;
+	Simulator::Cancel (m_handoffEvent);
+	Simulator::Cancel (m_prepushEvent);
+}
+
+uint32_t
+HandoffScheduler::GetHandoffs () const
+{
+	return m_handoffs;
+}
+
+void
+HandoffScheduler::OnCourseChange (Ptr<const MobilityModel> mobility)
+{
+	if (m_running)
+		Reschedule ();
+}
+
+void
+HandoffScheduler::Reschedule ()
+{
+	Simulator::Cancel (m_handoffEvent);
+	Simulator::Cancel (m_prepushEvent);
+
+	Vector pos = m_mobility->GetPosition ();
+	Vector vel = m_mobility->GetVelocity ();
+	Vector a = m_aps->GetPosition (m_current);
+
+	// A course change may have put the mobile in another AP's area. On a
+	// bisector, as right after a handoff, both APs are as good
+	uint32_t nearest = m_aps->Nearest (pos);
+	if (nearest != m_current
+	    && SquaredDistance (pos, m_aps->GetPosition (nearest)) < SquaredDistance (pos, a) * (1 - 1e-9))
+	{
+		m_handoffEvent = Simulator::Schedule (Seconds (0), &HandoffScheduler::Handoff, this, nearest);
+		return;
+	}
+
+	if (vel.x == 0 && vel.y == 0 && vel.z == 0)
+		return;
+
+	m_aps->KNearest (a, m_neighbours + 1, m_candidates);
+
+	uint32_t next = m_current;
+	double first = FirstCrossing (pos, vel, next);
+
+	// The distance to a grows slower than to any AP crossed later, so an AP
+	// closer than a at the crossing point was crossed earlier. Add it and
+	// look again
+	while (first >= 0)
+	{
+		Vector p (pos.x + vel.x * first, pos.y + vel.y * first, pos.z + vel.z * first);
+		uint32_t closer = m_aps->Nearest (p);
+
+		if (closer == m_current || closer == next
+		    || SquaredDistance (p, m_aps->GetPosition (closer)) >= SquaredDistance (p, a) * (1 - 1e-9)
+		    || std::find (m_candidates.begin (), m_candidates.end (), closer) != m_candidates.end ())
+			break;
+
+		m_candidates.push_back (closer);
+		first = FirstCrossing (pos, vel, next);
+	}
+
+	// None of the neighbours is ahead, only the whole deployment can say
+	// whether the mobile ever leaves the area
+	if (first < 0)
+	{
+		m_candidates.clear ();
+		for (uint32_t i = 0; i < m_aps->GetN (); i++)
+			m_candidates.push_back (i);
+
+		first = FirstCrossing (pos, vel, next);
+	}
+
+	if (first < 0)
+		return;
+
+	NS_LOG_INFO ("Next handoff from " << m_aps->GetSsid (m_current) << " to " << m_aps->GetSsid (next)
+			<< " in " << first << "s");
+
+	m_handoffEvent = Simulator::Schedule (Seconds (first), &HandoffScheduler::Handoff, this, next);
+
+	if (!m_prepush.IsNull ())
+		m_prepushEvent = Simulator::Schedule (Max (Seconds (first) - m_lead, Seconds (0)), &HandoffScheduler::Prepush, this, next);
+}
+
+double
+HandoffScheduler::FirstCrossing (Vector pos, Vector vel, uint32_t &next) const
+{
+	Vector a = m_aps->GetPosition (m_current);
+	double fromA = SquaredDistance (pos, a);
+	double first = -1;
+
+	for (uint32_t i = 0; i < m_candidates.size (); i++)
+	{
+		if (m_candidates[i] == m_current)
+			continue;
+
+		Vector b = m_aps->GetPosition (m_candidates[i]);
+
+		// Rate at which b gets closer than a, as squared distances
+		double approach = vel.x * (b.x - a.x) + vel.y * (b.y - a.y) + vel.z * (b.z - a.z);
+
+		if (approach <= 0)
+			continue;
+
+		double t = std::max (0.0, (SquaredDistance (pos, b) - fromA) / (2 * approach));
+
+		if (first < 0 || t < first)
+		{
+			first = t;
+			next = m_candidates[i];
+		}
+	}
+
+	return first;
+}
+
+void
+HandoffScheduler::Handoff (uint32_t ap)
+{
+	m_current = ap;
+	m_handoffs++;
+
+	if (!m_handoff.IsNull ())
+		m_handoff (m_aps->GetSsid (ap));
+
+	Reschedule ();
+}
+
+void
+HandoffScheduler::Prepush (uint32_t ap)
+{
+	m_prepush (m_aps->GetSsid (m_current), m_aps->GetSsid (ap));
+}
+
+} /* namespace ns3 */
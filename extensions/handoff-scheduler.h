@@ -0,0 +1,107 @@
+/* -*- Mode:C++; c-file-style:"gnu"; -*- */
+/*
+ *
+ * Copyright (c) 2014 Waseda University, Sato Laboratory
+ * Author: Jairo Eduardo Lopez <jairo@ruri.waseda.jp>
+ *
+ *  handoff-scheduler.h is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  handoff-scheduler.h is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero Public License
+ *  along with handoff-scheduler.h.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HANDOFF_SCHEDULER_H_
+#define HANDOFF_SCHEDULER_H_
+
+#include <string>
+#include <vector>
+
+#include <ns3-dev/ns3/callback.h>
+#include <ns3-dev/ns3/event-id.h>
+#include <ns3-dev/ns3/mobility-model.h>
+#include <ns3-dev/ns3/nstime.h>
+#include <ns3-dev/ns3/ptr.h>
+#include <ns3-dev/ns3/simple-ref-count.h>
+
+#include "ap-grid-index.h"
+
+namespace ns3 {
+
+/**
+ * \brief Hands a mobile over to the closest AP when its trajectory says so
+ *
+ * Between course changes a mobile moves in a straight line, so the time
+ * it crosses the bisector between its AP and each neighbouring AP is
+ * known in advance. Only the earliest crossing is scheduled, and it is
+ * recomputed on every CourseChange of the mobility model and after
+ * every handoff. The crossings are first looked for among the APs closest
+ * to the current one, then the crossing point is checked against the
+ * nearest AP, so a neighbouring area further away is not missed.
+ */
+class HandoffScheduler : public SimpleRefCount<HandoffScheduler> {
+public:
+	HandoffScheduler (Ptr<MobilityModel> mobility, const ApGridIndex *aps, uint32_t neighbours = 12);
+
+	// Called with the SSID of the AP the mobile should now use
+	void
+	SetHandoffCallback (Callback<void, std::string> handoff);
+
+	// Called lead before a handoff with the SSIDs of the current and the
+	// next AP, or right away if the handoff is closer than that
+	void
+	SetPrepushCallback (Callback<void, std::string, std::string> prepush, Time lead);
+
+	// Hand the mobile to the closest AP and follow it from now on
+	void
+	Start ();
+
+	void
+	Stop ();
+
+	uint32_t
+	GetHandoffs () const;
+
+private:
+	void
+	OnCourseChange (Ptr<const MobilityModel> mobility);
+
+	// Find the earliest bisector crossing along the current velocity
+	void
+	Reschedule ();
+
+	// Earliest crossing with the candidates, -1 if none is ahead
+	double
+	FirstCrossing (Vector pos, Vector vel, uint32_t &next) const;
+
+	void
+	Handoff (uint32_t ap);
+
+	void
+	Prepush (uint32_t ap);
+
+	Ptr<MobilityModel> m_mobility;
+	const ApGridIndex *m_aps;
+	uint32_t m_neighbours;
+	std::vector<uint32_t> m_candidates;
+
+	Callback<void, std::string> m_handoff;
+	Callback<void, std::string, std::string> m_prepush;
+	Time m_lead;
+
+	bool m_running;
+	uint32_t m_current;
+	uint32_t m_handoffs;
+	EventId m_handoffEvent;
+	EventId m_prepushEvent;
+};
+
+} /* namespace ns3 */
+
+#endif /* HANDOFF_SCHEDULER_H_ */
@@ -0,0 +1,478 @@
+/* -*- Mode:C++; c-file-style:"gnu"; -*- */
+/*
+ *
+ * Copyright (c) 2014 Waseda University, Sato Laboratory
+ * Author: Jairo Eduardo Lopez <jairo@ruri.waseda.jp>
+ *
+ *  icc-topology.cc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  icc-topology.cc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero Public License
+ *  along with icc-topology.cc.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "icc-topology.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include <boost/lexical_cast.hpp>
+
+#include <ns3-dev/ns3/assert.h>
+#include <ns3-dev/ns3/channel.h>
+#include <ns3-dev/ns3/log.h>
+#include <ns3-dev/ns3/mobility-module.h>
+#include <ns3-dev/ns3/point-to-point-module.h>
+#include <ns3-dev/ns3/string.h>
+#include <ns3-dev/ns3/wifi-net-device.h>
+#include <ns3-dev/ns3/ndnSIM/model/ndn-l3-protocol.h>
+#include <ns3-dev/ns3/ndnSIM/model/ndn-net-device-face.h>
+
+NS_LOG_COMPONENT_DEFINE ("IccTopology");
+
+namespace ns3 {
+
+IccTopology::IccTopology ()
+{
+}
+
+void
+IccTopology::LoadDefault (uint32_t servers)
+{
+	AddServer ("server-0", Vector (150, -100, 0));
+	for (uint32_t i = 1; i < servers; i++)
+		AddServer ("server-" + boost::lexical_cast<std::string> (i), Vector (150, -100, 0));
+
+	AddCentral ("central-0", Vector (50, -50, 0));
+	AddCentral ("central-1", Vector (250, -50, 0));
+
+	AddAp ("ap-0", Vector (0, 0, 0), "central-0");
+	AddAp ("ap-1", Vector (100, 0, 0), "central-0");
+	AddAp ("ap-2", Vector (200, 0, 0), "central-1");
+	AddAp ("ap-3", Vector (300, 0, 0), "central-1");
+
+	// In the order the scenarios always used, so Face ids do not change
+	AddLink ("central-0", "ap-0");
+	AddLink ("central-0", "ap-1");
+	AddLink ("central-1", "ap-2");
+	AddLink ("central-1", "ap-3");
+	AddLink ("server-0", "central-0");
+	AddLink ("server-0", "central-1");
+}
+
+bool
+IccTopology::Load (const std::string &file)
+{
+	std::ifstream in (file.c_str ());
+
+	if (!in.is_open ())
+		return Fail ("Cannot open " + file);
+
+	std::string line;
+	uint32_t lineNo = 0;
+
+	while (std::getline (in, line))
+	{
+		lineNo++;
+
+		size_t comment = line.find ('#');
+		if (comment != std::string::npos)
+			line.erase (comment);
+
+		std::istringstream tokens (line);
+		std::string kind;
+
+		if (!(tokens >> kind))
+			continue;
+
+		std::ostringstream where;
+		where << file << ":" << lineNo << ": ";
+
+		std::string name;
+		std::string extra;
+		bool ok = false;
+
+		if (kind == "server" || kind == "central" || kind == "ap")
+		{
+			double x, y;
+			if (!(tokens >> name >> x >> y))
+				return Fail (where.str () + "expected " + kind + " <name> <x> <y>");
+
+			if (kind == "server")
+				ok = AddServer (name, Vector (x, y, 0));
+			else if (kind == "central")
+				ok = AddCentral (name, Vector (x, y, 0));
+			else if (tokens >> extra)
+				ok = AddAp (name, Vector (x, y, 0), extra);
+			else
+				return Fail (where.str () + "expected ap <name> <x> <y> <central>");
+		}
+		else if (kind == "link")
+		{
+			std::string rate = "100Mbps";
+			std::string delay = "1ms";
+
+			if (!(tokens >> name >> extra))
+				return Fail (where.str () + "expected link <name> <name> [<data rate> <delay>]");
+
+			if (tokens >> rate && !(tokens >> delay))
+				return Fail (where.str () + "link data rate given without a delay");
+
+			ok = AddLink (name, extra, rate, delay);
+		}
+		else
+			return Fail (where.str () + "unknown declaration " + kind);
+
+		if (!ok)
+			return Fail (where.str () + m_error);
+	}
+
+	return true;
+}
+
+bool
+IccTopology::LoadHexagon (const std::string &file, uint32_t servers)
+{
+	std::ifstream in (file.c_str ());
+
+	if (!in.is_open ())
+		return Fail ("Cannot open " + file);
+
+	std::vector<double> values;
+	double area[2];
+
+	// Size of the area, then the gateways
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		if (!ReadValues (in, values) || values.size () != 1)
+			return Fail (file + ": expected the X and Y sizes and the number of gateways");
+
+		if (i < 2)
+			area[i] = values[0];
+	}
+
+	uint32_t gateways = values[0];
+	std::vector<Vector> gwPos;
+
+	for (uint32_t i = 0; i < gateways; i++)
+	{
+		if (!ReadValues (in, values) || values.size () != 2)
+			return Fail (file + ": expected the position of gateway " + boost::lexical_cast<std::string> (i));
+
+		gwPos.push_back (Vector (values[0], values[1], 0));
+	}
+
+	// Wireless nodes per gateway and in total, then their positions
+	if (!ReadValues (in, values) || values.size () != 1)
+		return Fail (file + ": expected the number of wireless nodes per gateway");
+
+	uint32_t perGw = values[0];
+
+	if (!ReadValues (in, values) || values.size () != 1)
+		return Fail (file + ": expected the total number of wireless nodes");
+
+	uint32_t total = values[0];
+
+	if (perGw == 0 || total != perGw * gateways)
+		return Fail (file + ": wireless node count does not match the gateways");
+
+	std::vector<Vector> apPos;
+
+	for (uint32_t i = 0; i < total; i++)
+	{
+		if (!ReadValues (in, values) || values.size () != 2)
+			return Fail (file + ": expected the position of wireless node " + boost::lexical_cast<std::string> (i));
+
+		apPos.push_back (Vector (values[0], values[1], 0));
+	}
+
+	// The server sits below the area, as in the default layout
+	for (uint32_t i = 0; i < servers; i++)
+		AddServer ("server-" + boost::lexical_cast<std::string> (i), Vector (area[0] / 2, -100, 0));
+
+	for (uint32_t i = 0; i < gateways; i++)
+		AddCentral ("central-" + boost::lexical_cast<std::string> (i), gwPos[i]);
+
+	// The generator writes the wireless nodes of each gateway together
+	for (uint32_t i = 0; i < total; i++)
+		AddAp ("ap-" + boost::lexical_cast<std::string> (i), apPos[i],
+				"central-" + boost::lexical_cast<std::string> (i / perGw));
+
+	for (uint32_t i = 0; i < total; i++)
+		AddLink ("central-" + boost::lexical_cast<std::string> (i / perGw), "ap-" + boost::lexical_cast<std::string> (i));
+
+	for (uint32_t i = 0; i < gateways; i++)
+		AddLink ("server-0", "central-" + boost::lexical_cast<std::string> (i));
+
+	NS_LOG_INFO ("Read " << gateways << " gateways and " << total << " wireless nodes over "
+			<< area[0] << "x" << area[1] << " from " << file);
+
+	return true;
+}
+
+bool
+IccTopology::AddServer (const std::string &name, Vector pos)
+{
+	return Declare (SERVER, name, pos, 0);
+}
+
+bool
+IccTopology::AddCentral (const std::string &name, Vector pos)
+{
+	return Declare (CENTRAL, name, pos, m_decls[CENTRAL].size ());
+}
+
+bool
+IccTopology::AddAp (const std::string &name, Vector pos, const std::string &central)
+{
+	std::map<std::string, std::pair<Kind, uint32_t> >::const_iterator it = m_names.find (central);
+
+	if (it == m_names.end () || it->second.first != CENTRAL)
+		return Fail ("unknown central node " + central);
+
+	return Declare (AP, name, pos, it->second.second);
+}
+
+bool
+IccTopology::AddLink (const std::string &a, const std::string &b,
+		const std::string &rate, const std::string &delay)
+{
+	if (m_names.find (a) == m_names.end ())
+		return Fail ("unknown node " + a);
+	if (m_names.find (b) == m_names.end ())
+		return Fail ("unknown node " + b);
+	if (a == b)
+		return Fail ("link from " + a + " to itself");
+
+	Link link = { a, b, rate, delay };
+	m_links.push_back (link);
+	return true;
+}
+
+void
+IccTopology::Build ()
+{
+	NS_ASSERT_MSG (m_nodes[CENTRAL].GetN () == 0, "Topology already built");
+
+	// Same creation order as the scenarios had, centrals before APs before
+	// servers
+	const Kind order[] = { CENTRAL, AP, SERVER };
+
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		m_nodes[order[i]].Create (m_decls[order[i]].size ());
+		Place (m_nodes[order[i]], m_decls[order[i]]);
+	}
+
+	for (uint32_t i = 0; i < m_links.size (); i++)
+	{
+		const Link &link = m_links[i];
+
+		PointToPointHelper p2p;
+		p2p.SetDeviceAttribute ("DataRate", StringValue (link.rate));
+		p2p.SetChannelAttribute ("Delay", StringValue (link.delay));
+
+		Ptr<Node> a = GetNode (link.a);
+		Ptr<Node> b = GetNode (link.b);
+		p2p.Install (a, b);
+
+		Kind ka = m_names[link.a].first;
+		Kind kb = m_names[link.b].first;
+
+		// Keep the first node one level up, APs only go up to their own
+		// central node
+		if (ka == AP && kb == CENTRAL && m_decls[AP][m_names[link.a].second].sector == m_names[link.b].second)
+			m_upstream.insert (std::make_pair (a->GetId (), b));
+		else if (kb == AP && ka == CENTRAL && m_decls[AP][m_names[link.b].second].sector == m_names[link.a].second)
+			m_upstream.insert (std::make_pair (b->GetId (), a));
+		else if (ka == CENTRAL && kb == SERVER)
+			m_upstream.insert (std::make_pair (a->GetId (), b));
+		else if (kb == CENTRAL && ka == SERVER)
+			m_upstream.insert (std::make_pair (b->GetId (), a));
+	}
+
+	NS_LOG_INFO ("Built " << m_nodes[SERVER].GetN () << " servers, " << m_nodes[CENTRAL].GetN ()
+			<< " central nodes, " << m_nodes[AP].GetN () << " APs and " << m_links.size () << " links");
+}
+
+NodeContainer
+IccTopology::GetServers () const
+{
+	return m_nodes[SERVER];
+}
+
+NodeContainer
+IccTopology::GetCentrals () const
+{
+	return m_nodes[CENTRAL];
+}
+
+NodeContainer
+IccTopology::GetAps () const
+{
+	return m_nodes[AP];
+}
+
+uint32_t
+IccTopology::GetSectors () const
+{
+	return m_decls[CENTRAL].size ();
+}
+
+uint32_t
+IccTopology::GetSector (uint32_t ap) const
+{
+	NS_ASSERT (ap < m_decls[AP].size ());
+	return m_decls[AP][ap].sector;
+}
+
+NodeContainer
+IccTopology::GetSectorAps (uint32_t sector) const
+{
+	NodeContainer aps;
+
+	for (uint32_t i = 0; i < m_decls[AP].size (); i++)
+	{
+		if (m_decls[AP][i].sector == sector)
+			aps.Add (m_nodes[AP].Get (i));
+	}
+
+	return aps;
+}
+
+Ptr<Node>
+IccTopology::GetUpstream (Ptr<Node> node) const
+{
+	std::map<uint32_t, Ptr<Node> >::const_iterator it = m_upstream.find (node->GetId ());
+
+	if (it == m_upstream.end ())
+		return 0;
+
+	return it->second;
+}
+
+const std::string &
+IccTopology::GetError () const
+{
+	return m_error;
+}
+
+bool
+IccTopology::Declare (Kind kind, const std::string &name, Vector pos, uint32_t sector)
+{
+	if (!m_names.insert (std::make_pair (name, std::make_pair (kind, (uint32_t) m_decls[kind].size ()))).second)
+		return Fail ("duplicate node " + name);
+
+	Declaration decl = { name, pos, sector };
+	m_decls[kind].push_back (decl);
+	return true;
+}
+
+bool
+IccTopology::Fail (const std::string &error)
+{
+	m_error = error;
+	return false;
+}
+
+bool
+IccTopology::ReadValues (std::istream &in, std::vector<double> &values)
+{
+	std::string line;
+
+	values.clear ();
+
+	while (values.empty () && std::getline (in, line))
+	{
+		std::replace (line.begin (), line.end (), ',', ' ');
+
+		std::istringstream tokens (line);
+		double value;
+
+		while (tokens >> value)
+			values.push_back (value);
+
+		if (!tokens.eof ())
+			return false;
+	}
+
+	return !values.empty ();
+}
+
+void
+IccTopology::Place (NodeContainer nodes, const std::vector<Declaration> &decls)
+{
+	if (decls.empty ())
+		return;
+
+	Ptr<ListPositionAllocator> positions = CreateObject<ListPositionAllocator> ();
+
+	for (uint32_t i = 0; i < decls.size (); i++)
+		positions->Add (decls[i].pos);
+
+	MobilityHelper mobility;
+	mobility.SetPositionAllocator (positions);
+	mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+	mobility.Install (nodes);
+}
+
+Ptr<Node>
+IccTopology::GetNode (const std::string &name) const
+{
+	std::map<std::string, std::pair<Kind, uint32_t> >::const_iterator it = m_names.find (name);
+
+	NS_ASSERT (it != m_names.end ());
+	return m_nodes[it->second.first].Get (it->second.second);
+}
+
+Ptr<ndn::Face>
+GetFaceTowards (Ptr<Node> from, Ptr<Node> to)
+{
+	Ptr<ndn::L3Protocol> protocol = from->GetObject<ndn::L3Protocol> ();
+
+	for (uint32_t i = 0; i < protocol->GetNFaces (); i++)
+	{
+		Ptr<ndn::NetDeviceFace> face = DynamicCast<ndn::NetDeviceFace> (protocol->GetFace (i));
+
+		if (face == 0)
+			continue;
+
+		Ptr<Channel> channel = face->GetNetDevice ()->GetChannel ();
+
+		if (channel == 0)
+			continue;
+
+		for (uint32_t j = 0; j < channel->GetNDevices (); j++)
+		{
+			if (channel->GetDevice (j)->GetNode () == to)
+				return face;
+		}
+	}
+
+	return 0;
+}
+
+Ptr<ndn::Face>
+GetWirelessFace (Ptr<Node> node)
+{
+	Ptr<ndn::L3Protocol> protocol = node->GetObject<ndn::L3Protocol> ();
+
+	for (uint32_t i = 0; i < protocol->GetNFaces (); i++)
+	{
+		Ptr<ndn::NetDeviceFace> face = DynamicCast<ndn::NetDeviceFace> (protocol->GetFace (i));
+
+		if (face != 0 && DynamicCast<WifiNetDevice> (face->GetNetDevice ()) != 0)
+			return face;
+	}
+
+	return 0;
+}
+
+} /* namespace ns3 */
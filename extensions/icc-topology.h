@@ -0,0 +1,166 @@
+/* -*- Mode:C++; c-file-style:"gnu"; -*- */
+/*
+ *
+ * Copyright (c) 2014 Waseda University, Sato Laboratory
+ * Author: Jairo Eduardo Lopez <jairo@ruri.waseda.jp>
+ *
+ *  icc-topology.h is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  icc-topology.h is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero Public License
+ *  along with icc-topology.h.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ICC_TOPOLOGY_H_
+#define ICC_TOPOLOGY_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <ns3-dev/ns3/ptr.h>
+#include <ns3-dev/ns3/node.h>
+#include <ns3-dev/ns3/node-container.h>
+#include <ns3-dev/ns3/vector.h>
+#include <ns3-dev/ns3/ndnSIM/model/ndn-face.h>
+
+namespace ns3 {
+
+/**
+ * \brief Servers, central nodes and access points of the ICC scenarios
+ *
+ * A topology file has one declaration per line, # starts a comment:
+ *
+ *   server <name> <x> <y>
+ *   central <name> <x> <y>
+ *   ap <name> <x> <y> <central>
+ *   link <name> <name> [<data rate> <delay>]
+ *
+ * Each AP belongs to the sector of the central node given, links default
+ * to 100Mbps and 1ms. Nodes are created centrals first, then APs, then
+ * servers, each in file order, and links are installed in file order.
+ * Everything is resolved through name lookups, so building costs
+ * n log n in the number of declarations.
+ */
+class IccTopology {
+public:
+	IccTopology ();
+
+	// The layout the scenarios were written for: two sectors of two APs
+	// below one server. Extra servers are created but not linked
+	void
+	LoadDefault (uint32_t servers = 1);
+
+	// False if the file cannot be read or is malformed, see GetError
+	bool
+	Load (const std::string &file);
+
+	// Read the output of random/hexagon-random.py: every gateway becomes a
+	// central node linked to server-0, every wireless node an AP in the
+	// sector of the gateway it was generated for
+	bool
+	LoadHexagon (const std::string &file, uint32_t servers = 1);
+
+	bool
+	AddServer (const std::string &name, Vector pos);
+
+	bool
+	AddCentral (const std::string &name, Vector pos);
+
+	bool
+	AddAp (const std::string &name, Vector pos, const std::string &central);
+
+	bool
+	AddLink (const std::string &a, const std::string &b,
+		 const std::string &rate = "100Mbps", const std::string &delay = "1ms");
+
+	// Create the nodes, give them a constant position and install the
+	// point to point links
+	void
+	Build ();
+
+	NodeContainer
+	GetServers () const;
+
+	NodeContainer
+	GetCentrals () const;
+
+	NodeContainer
+	GetAps () const;
+
+	uint32_t
+	GetSectors () const;
+
+	// Sector of the ith AP, which is the index of its central node
+	uint32_t
+	GetSector (uint32_t ap) const;
+
+	NodeContainer
+	GetSectorAps (uint32_t sector) const;
+
+	// Central node of an AP, first server linked to a central node, 0
+	// otherwise
+	Ptr<Node>
+	GetUpstream (Ptr<Node> node) const;
+
+	const std::string &
+	GetError () const;
+
+private:
+	enum Kind { SERVER, CENTRAL, AP };
+
+	struct Declaration {
+		std::string name;
+		Vector pos;
+		uint32_t sector;
+	};
+
+	struct Link {
+		std::string a;
+		std::string b;
+		std::string rate;
+		std::string delay;
+	};
+
+	bool
+	Declare (Kind kind, const std::string &name, Vector pos, uint32_t sector);
+
+	bool
+	Fail (const std::string &error);
+
+	// Next non empty line of in as numbers, commas taken as blanks
+	static bool
+	ReadValues (std::istream &in, std::vector<double> &values);
+
+	void
+	Place (NodeContainer nodes, const std::vector<Declaration> &decls);
+
+	Ptr<Node>
+	GetNode (const std::string &name) const;
+
+	std::vector<Declaration> m_decls[3];
+	std::map<std::string, std::pair<Kind, uint32_t> > m_names;
+	std::vector<Link> m_links;
+
+	NodeContainer m_nodes[3];
+	std::map<uint32_t, Ptr<Node> > m_upstream;
+	std::string m_error;
+};
+
+// Face on from that has a point to point link to to, 0 if none
+Ptr<ndn::Face>
+GetFaceTowards (Ptr<Node> from, Ptr<Node> to);
+
+// Face on the Wifi device of node, 0 if none
+Ptr<ndn::Face>
+GetWirelessFace (Ptr<Node> node);
+
+} /* namespace ns3 */
+
+#endif /* ICC_TOPOLOGY_H_ */
@@ -0,0 +1,229 @@
+/* -*- Mode:C++; c-file-style:"gnu"; -*- */
+/*
+ *
+ * Copyright (c) 2014 Waseda University, Sato Laboratory
+ * Author: Jairo Eduardo Lopez <jairo@ruri.waseda.jp>
+ *
+ *  interest-schedule.cc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  interest-schedule.cc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero Public License
+ *  along with interest-schedule.cc.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "interest-schedule.h"
+
+#include <algorithm>
+
+namespace ns3 {
+namespace ndn {
+
+namespace {
+
+const char MAGIC[4] = { 'I', 'S', 'C', 'H' };
+const uint32_t VERSION = 2;
+
+// Longest prefix URI a schedule holds
+const uint64_t MAX_PREFIX = 0xffff;
+
+void
+PutLe (std::ostream &os, uint64_t value, uint32_t bytes)
+{
+	for (uint32_t i = 0; i < bytes; i++)
+		os.put (static_cast<char> ((value >> (8 * i)) & 0xff));
+}
+
+bool
+GetLe (std::istream &is, uint64_t &value, uint32_t bytes)
+{
+	unsigned char buf[8];
+
+	if (!is.read (reinterpret_cast<char *> (buf), bytes))
+		return false;
+
+	value = 0;
+	for (uint32_t i = 0; i < bytes; i++)
+		value |= static_cast<uint64_t> (buf[i]) << (8 * i);
+
+	return true;
+}
+
+void
+PutVarint (std::ostream &os, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		os.put (static_cast<char> ((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+	os.put (static_cast<char> (value));
+}
+
+bool
+GetVarint (std::istream &is, uint64_t &value)
+{
+	value = 0;
+	for (uint32_t shift = 0; shift < 64; shift += 7)
+	{
+		int c = is.get ();
+		if (c == std::char_traits<char>::eof ())
+			return false;
+
+		value |= static_cast<uint64_t> (c & 0x7f) << shift;
+		if ((c & 0x80) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+} // namespace
+
+InterestScheduleWriter::InterestScheduleWriter ()
+	: m_records (0)
+{
+}
+
+InterestScheduleWriter::~InterestScheduleWriter ()
+{
+	Close ();
+}
+
+bool
+InterestScheduleWriter::Open (const std::string &file)
+{
+	Close ();
+
+	m_os.open (file.c_str (), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!m_os.is_open ())
+		return false;
+
+	m_os.write (MAGIC, sizeof (MAGIC));
+	PutLe (m_os, VERSION, 4);
+	m_records = 0;
+	m_prefixes.clear ();
+
+	return true;
+}
+
+bool
+InterestScheduleWriter::Write (Time time, const std::string &prefix, uint64_t seq)
+{
+	if (prefix.size () > MAX_PREFIX)
+		return false;
+
+	PutVarint (m_os, time.GetNanoSeconds ());
+
+	std::map<std::string, uint64_t>::iterator it = m_prefixes.find (prefix);
+	if (it != m_prefixes.end ())
+		PutVarint (m_os, it->second);
+	else
+	{
+		uint64_t index = m_prefixes.size ();
+		m_prefixes[prefix] = index;
+
+		PutVarint (m_os, index);
+		PutVarint (m_os, prefix.size ());
+		m_os.write (prefix.data (), prefix.size ());
+	}
+
+	PutVarint (m_os, seq);
+	m_records++;
+
+	return true;
+}
+
+void
+InterestScheduleWriter::Close ()
+{
+	if (m_os.is_open ())
+		m_os.close ();
+}
+
+bool
+InterestScheduleWriter::IsOpen () const
+{
+	return m_os.is_open ();
+}
+
+uint64_t
+InterestScheduleWriter::GetRecords () const
+{
+	return m_records;
+}
+
+InterestScheduleReader::InterestScheduleReader ()
+{
+}
+
+bool
+InterestScheduleReader::Open (const std::string &file)
+{
+	Close ();
+
+	m_is.open (file.c_str (), std::ios::in | std::ios::binary);
+	if (!m_is.is_open ())
+		return false;
+
+	char magic[4];
+	uint64_t version;
+
+	if (!m_is.read (magic, sizeof (magic)) || !std::equal (magic, magic + 4, MAGIC)
+	    || !GetLe (m_is, version, 4) || version != VERSION)
+	{
+		Close ();
+		return false;
+	}
+
+	return true;
+}
+
+bool
+InterestScheduleReader::Next (Time &time, std::string &prefix, uint64_t &seq)
+{
+	uint64_t ns;
+	uint64_t index;
+
+	if (!m_is.is_open () || !GetVarint (m_is, ns) || !GetVarint (m_is, index))
+		return false;
+
+	if (index == m_prefixes.size ())
+	{
+		uint64_t length;
+		if (!GetVarint (m_is, length) || length > MAX_PREFIX)
+			return false;
+
+		std::string uri (length, '\0');
+		if (length > 0 && !m_is.read (&uri[0], length))
+			return false;
+
+		m_prefixes.push_back (uri);
+	}
+	else if (index > m_prefixes.size ())
+		return false;
+
+	if (!GetVarint (m_is, seq))
+		return false;
+
+	prefix = m_prefixes[index];
+	time = NanoSeconds (static_cast<int64_t> (ns));
+	return true;
+}
+
+void
+InterestScheduleReader::Close ()
+{
+	if (m_is.is_open ())
+		m_is.close ();
+	m_is.clear ();
+	m_prefixes.clear ();
+}
+
+} /* namespace ndn */
+} /* namespace ns3 */
@@ -0,0 +1,94 @@
+/* -*- Mode:C++; c-file-style:"gnu"; -*- */
+/*
+ *
+ * Copyright (c) 2014 Waseda University, Sato Laboratory
+ * Author: Jairo Eduardo Lopez <jairo@ruri.waseda.jp>
+ *
+ *  interest-schedule.h is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  interest-schedule.h is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero Public License
+ *  along with interest-schedule.h.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INTEREST_SCHEDULE_H_
+#define INTEREST_SCHEDULE_H_
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <ns3-dev/ns3/nstime.h>
+
+namespace ns3 {
+namespace ndn {
+
+/**
+ * \brief Binary file of Interest names and the time they were sent at
+ *
+ * The file starts with the magic "ISCH" and a 32 bit little endian version,
+ * followed by one record per Interest. A record is a series of varints
+ * (7 bits per byte, low bits first): the time in nanoseconds from the start
+ * of the application, the index of the name prefix and the sequence number
+ * appended to it. An index one past the prefixes seen so far brings a new
+ * prefix, stored as the length of its URI followed by the URI itself.
+ */
+class InterestScheduleWriter {
+public:
+	InterestScheduleWriter ();
+
+	~InterestScheduleWriter ();
+
+	bool
+	Open (const std::string &file);
+
+	// False when the prefix URI is longer than the format allows
+	bool
+	Write (Time time, const std::string &prefix, uint64_t seq);
+
+	void
+	Close ();
+
+	bool
+	IsOpen () const;
+
+	uint64_t
+	GetRecords () const;
+
+private:
+	std::ofstream m_os;
+	uint64_t m_records;
+	std::map<std::string, uint64_t> m_prefixes;
+};
+
+class InterestScheduleReader {
+public:
+	InterestScheduleReader ();
+
+	// False when the file cannot be read or is not a schedule
+	bool
+	Open (const std::string &file);
+
+	// Read the next record, false at the end of the file
+	bool
+	Next (Time &time, std::string &prefix, uint64_t &seq);
+
+	void
+	Close ();
+
+private:
+	std::ifstream m_is;
+	std::vector<std::string> m_prefixes;
+};
+
+} /* namespace ndn */
+} /* namespace ns3 */
+
+#endif /* INTEREST_SCHEDULE_H_ */
@@ -0,0 +1,181 @@
+/* -*- Mode:C++; c-file-style:"gnu"; -*- */
+/*
+ *
+ * Copyright (c) 2014 Waseda University, Sato Laboratory
+ * Author: Jairo Eduardo Lopez <jairo@ruri.waseda.jp>
+ *
+ *  log-histogram.cc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  log-histogram.cc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero Public License
+ *  along with log-histogram.cc.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "log-histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <ns3-dev/ns3/assert.h>
+
+namespace ns3 {
+namespace ndn {
+
+LogHistogram::LogHistogram (uint32_t subBucketBits)
+	: m_subBucketBits (subBucketBits)
+	, m_count (0)
+	, m_min (0)
+	, m_max (0)
+	, m_sum (0)
+{
+	NS_ASSERT (subBucketBits > 0 && subBucketBits < 16);
+}
+
+void
+LogHistogram::Record (uint64_t value, uint64_t count)
+{
+	if (count == 0)
+		return;
+
+	uint32_t index = GetIndex (value);
+
+	if (index >= m_buckets.size ())
+		m_buckets.resize (index + 1, 0);
+
+	m_buckets[index] += count;
+
+	if (m_count == 0 || value < m_min)
+		m_min = value;
+	if (m_count == 0 || value > m_max)
+		m_max = value;
+
+	m_count += count;
+	m_sum += (double) value * count;
+}
+
+void
+LogHistogram::Merge (const LogHistogram &other)
+{
+	NS_ASSERT (m_subBucketBits == other.m_subBucketBits);
+
+	if (other.m_count == 0)
+		return;
+
+	if (other.m_buckets.size () > m_buckets.size ())
+		m_buckets.resize (other.m_buckets.size (), 0);
+
+	for (uint32_t i = 0; i < other.m_buckets.size (); i++)
+		m_buckets[i] += other.m_buckets[i];
+
+	if (m_count == 0 || other.m_min < m_min)
+		m_min = other.m_min;
+	if (m_count == 0 || other.m_max > m_max)
+		m_max = other.m_max;
+
+	m_count += other.m_count;
+	m_sum += other.m_sum;
+}
+
+uint64_t
+LogHistogram::GetCount () const
+{
+	return m_count;
+}
+
+uint64_t
+LogHistogram::GetMin () const
+{
+	return m_min;
+}
+
+uint64_t
+LogHistogram::GetMax () const
+{
+	return m_max;
+}
+
+double
+LogHistogram::GetMean () const
+{
+	return m_count > 0 ? m_sum / m_count : 0;
+}
+
+uint64_t
+LogHistogram::GetPercentile (double percentile) const
+{
+	if (m_count == 0)
+		return 0;
+
+	uint64_t target = (uint64_t) std::ceil (std::min (percentile, 100.0) / 100.0 * m_count);
+	if (target == 0)
+		target = 1;
+
+	uint64_t seen = 0;
+
+	for (uint32_t i = 0; i < m_buckets.size (); i++)
+	{
+		seen += m_buckets[i];
+
+		if (seen >= target)
+			return std::min (std::max (GetUpperBound (i), m_min), m_max);
+	}
+
+	return m_max;
+}
+
+bool
+LogHistogram::IsEmpty () const
+{
+	return m_count == 0;
+}
+
+void
+LogHistogram::Reset ()
+{
+	m_buckets.clear ();
+	m_count = 0;
+	m_min = 0;
+	m_max = 0;
+	m_sum = 0;
+}
+
+uint32_t
+LogHistogram::GetIndex (uint64_t value) const
+{
+	uint64_t sub = 1ULL << m_subBucketBits;
+
+	if (value < sub)
+		return value;
+
+	uint32_t exponent = 0;
+	for (uint64_t v = value; v >>= 1; )
+		exponent++;
+
+	uint32_t shift = exponent - m_subBucketBits;
+
+	// The leading bit is implied, the next subBucketBits pick the bucket
+	return sub + shift * sub + ((value >> shift) - sub);
+}
+
+uint64_t
+LogHistogram::GetUpperBound (uint32_t index) const
+{
+	uint64_t sub = 1ULL << m_subBucketBits;
+
+	if (index < sub)
+		return index;
+
+	uint32_t shift = (index - sub) / sub;
+	uint64_t lower = (sub + (index - sub) % sub) << shift;
+
+	return lower + (1ULL << shift) - 1;
+}
+
+} /* namespace ndn */
+} /* namespace ns3 */
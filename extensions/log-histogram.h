@@ -0,0 +1,93 @@
+/* -*- Mode:C++; c-file-style:"gnu"; -*- */
+/*
+ *
+ * Copyright (c) 2014 Waseda University, Sato Laboratory
+ * Author: Jairo Eduardo Lopez <jairo@ruri.waseda.jp>
+ *
+ *  log-histogram.h is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  log-histogram.h is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero Public License
+ *  along with log-histogram.h.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOG_HISTOGRAM_H_
+#define LOG_HISTOGRAM_H_
+
+#include <vector>
+
+#include <stdint.h>
+
+namespace ns3 {
+namespace ndn {
+
+/**
+ * \brief Histogram with logarithmic buckets, in the style of HdrHistogram
+ *
+ * Each power of two is split in 2^subBucketBits linear buckets, so any
+ * recorded value is known within a relative error of 2^-subBucketBits
+ * (about 3% with the default) whatever its magnitude. Values below
+ * 2^subBucketBits are kept exactly. Memory grows with the logarithm of
+ * the largest value recorded.
+ */
+class LogHistogram {
+public:
+	LogHistogram (uint32_t subBucketBits = 5);
+
+	void
+	Record (uint64_t value, uint64_t count = 1);
+
+	// Add all the values recorded in other, which must use the same
+	// number of sub-buckets
+	void
+	Merge (const LogHistogram &other);
+
+	uint64_t
+	GetCount () const;
+
+	uint64_t
+	GetMin () const;
+
+	uint64_t
+	GetMax () const;
+
+	double
+	GetMean () const;
+
+	// Smallest value such that at least percentile % of the recorded
+	// values are at or below it, within the bucket precision
+	uint64_t
+	GetPercentile (double percentile) const;
+
+	bool
+	IsEmpty () const;
+
+	void
+	Reset ();
+
+private:
+	uint32_t
+	GetIndex (uint64_t value) const;
+
+	// Highest value that falls in the bucket
+	uint64_t
+	GetUpperBound (uint32_t index) const;
+
+	uint32_t m_subBucketBits;
+	std::vector<uint64_t> m_buckets;
+	uint64_t m_count;
+	uint64_t m_min;
+	uint64_t m_max;
+	double m_sum;
+};
+
+} /* namespace ndn */
+} /* namespace ns3 */
+
+#endif /* LOG_HISTOGRAM_H_ */
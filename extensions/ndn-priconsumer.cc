@@ -7,6 +7,17 @@
 
 #include "ndn-priconsumer.h"
 
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+#include <boost/random/geometric_distribution.hpp>
+#include <boost/random/mersenne_twister.hpp>
+
+#include <ns3-dev/ns3/ndnSIM/model/fw/ndn-forwarding-strategy.h>
+#include <ns3-dev/ns3/sta-wifi-mac.h>
+#include <ns3-dev/ns3/wifi-net-device.h>
+
 namespace ns3 {
 namespace ndn {
 
@@ -19,45 +30,859 @@ PriConsumer::GetTypeId (void)
     .SetGroupName ("Ndn")
     .SetParent<ConsumerCbr> ()
     .AddConstructor<PriConsumer> ()
+    .AddAttribute ("RetxWheel", "Keep a timer per sequence number instead of checking the timeouts every RetxTimer",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&PriConsumer::m_useWheel),
+                   MakeBooleanChecker ())
+    .AddAttribute ("RetxWheelTick", "Resolution of the retransmission timers",
+                   TimeValue (MilliSeconds (5)),
+                   MakeTimeAccessor (&PriConsumer::SetWheelTick, &PriConsumer::GetWheelTick),
+                   MakeTimeChecker ())
+    .AddAttribute ("RetxWheelSlots", "Number of slots of the retransmission timer wheel",
+                   UintegerValue (512),
+                   MakeUintegerAccessor (&PriConsumer::SetWheelSlots, &PriConsumer::GetWheelSlots),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("HandoffPacing", "Hold Interests while the station is not associated and release a burst on reassociation",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PriConsumer::m_pacing),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MaxReleaseBurst", "Maximum number of Interests released at once on reassociation",
+                   UintegerValue (64),
+                   MakeUintegerAccessor (&PriConsumer::m_maxBurst),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("WindowControl", "Send as many Interests as an AIMD window allows instead of at Frequency",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PriConsumer::m_windowControl),
+                   MakeBooleanChecker ())
+    .AddAttribute ("InitialWindow", "Interests in flight when starting",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&PriConsumer::m_initialWindow),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("MaxWindow", "Maximum number of Interests in flight",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&PriConsumer::m_maxWindow),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("HandoffGrace", "Losses of Interests sent before reassociation plus this time do not shrink the window",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&PriConsumer::m_handoffGrace),
+                   MakeTimeChecker ())
+    .AddAttribute ("CountDeliveries", "Classify the Data reaching the node as useful, duplicate, late or unsolicited",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PriConsumer::m_countDeliveries),
+                   MakeBooleanChecker ())
+    .AddAttribute ("RecordFile", "File where the first transmission of every Interest is recorded for ReplayConsumer, empty to disable",
+                   StringValue (""),
+                   MakeStringAccessor (&PriConsumer::m_recordFile),
+                   MakeStringChecker ())
+    .AddAttribute ("HistogramFile", "File where the delay percentiles are written at the end, empty to disable",
+                   StringValue (""),
+                   MakeStringAccessor (&PriConsumer::m_histFile),
+                   MakeStringChecker ())
+    .AddAttribute ("HistogramWindow", "Length of the windows the delay percentiles are reported for",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&PriConsumer::m_histWindow),
+                   MakeTimeChecker ())
+    .AddAttribute ("Contents", "Number of content objects to choose from with Zipf popularity, 0 to fetch Prefix only",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&PriConsumer::m_contents),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("ZipfAlpha", "Exponent of the Zipf popularity of the content objects",
+                   DoubleValue (0.8),
+                   MakeDoubleAccessor (&PriConsumer::m_zipfAlpha),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("AvgContentSize", "Average size of a content object in MB, sizes are geometrically distributed",
+                   DoubleValue (1),
+                   MakeDoubleAccessor (&PriConsumer::m_avgContentSize),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("ChunkSize", "Payload of each Data in bytes, to turn content sizes into sequence numbers",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&PriConsumer::m_chunkSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("CatalogSeed", "Seed of the content sizes, consumers with the same seed agree on them",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&PriConsumer::m_catalogSeed),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddTraceSource ("DuplicateData", "Data received again by the node",
+                     MakeTraceSourceAccessor (&PriConsumer::m_duplicateData))
+    .AddTraceSource ("LateData", "Data received after its Interest timed out",
+                     MakeTraceSourceAccessor (&PriConsumer::m_lateData))
+    .AddTraceSource ("UnsolicitedData", "Data received without having been requested",
+                     MakeTraceSourceAccessor (&PriConsumer::m_unsolicitedData))
+    .AddTraceSource ("CongestionWindow", "Window after each change",
+                     MakeTraceSourceAccessor (&PriConsumer::m_windowTrace))
+    .AddTraceSource ("ContentComplete", "Content object, number of Data and time taken to fetch it",
+                     MakeTraceSourceAccessor (&PriConsumer::m_contentComplete))
+    .AddTraceSource ("SeqTimeout", "Sequence number whose Interest timed out",
+                     MakeTraceSourceAccessor (&PriConsumer::m_seqTimeout))
+    .AddTraceSource ("HandoffRelease", "Number of Interests released on reassociation",
+                     MakeTraceSourceAccessor (&PriConsumer::m_handoffRelease))
     ;
 
   return tid;
 }
 
-std::set<uint32_t>
-PriConsumer::GetSeqTimeout ()
+PriConsumer::PriConsumer ()
+	: m_useWheel (true)
+	, m_wheelSlots (512)
+	, m_pacing (false)
+	, m_maxBurst (64)
+	, m_detached (false)
+	, m_savedInterests (0)
+	, m_releasedInterests (0)
+	, m_heldInterests (0)
+	, m_sentInterests (0)
+	, m_hasAp (false)
+	, m_handoffs (0)
+	, m_countDeliveries (false)
+	, m_histWindow (Seconds (1))
+	, m_windowIndex (0)
+	, m_epochIndex (0)
+	, m_stopped (false)
+	, m_windowControl (false)
+	, m_initialWindow (1)
+	, m_maxWindow (1024)
+	, m_handoffGrace (MilliSeconds (100))
+	, m_cwnd (1)
+	, m_ssthresh (1024)
+	, m_ignoredLosses (0)
+	, m_contents (0)
+	, m_zipfAlpha (0.8)
+	, m_avgContentSize (1)
+	, m_chunkSize (1024)
+	, m_catalogSeed (1)
+	, m_zipfRng (0, 1)
+	, m_contentId (0)
+	, m_completed (0)
+	, m_staleData (0)
+	, m_logTimeouts (false)
+{
+}
+
+void
+PriConsumer::StartApplication ()
+{
+	if (m_contents > 0)
+	{
+		m_basePrefix = m_interestName;
+		BuildCatalog ();
+		NextContent ();
+	}
+
+	m_cwnd = m_initialWindow;
+	m_ssthresh = m_maxWindow;
+
+	if (!m_recordFile.empty ())
+	{
+		if (!m_recorder.Open (m_recordFile))
+			NS_LOG_UNCOND ("PriConsumer: cannot open " << m_recordFile);
+		m_recordStart = Simulator::Now ();
+	}
+
+	ConsumerCbr::StartApplication ();
+
+	// The wheel takes over from the periodic timeout check
+	if (m_useWheel)
+		Simulator::Cancel (m_retxEvent);
+
+	if (!m_histFile.empty ())
+	{
+		m_window.start = m_epoch.start = m_total.start = Simulator::Now ();
+
+		TraceConnectWithoutContext ("FirstInterestDataDelay", MakeCallback (&PriConsumer::OnFirstDelay, this));
+		TraceConnectWithoutContext ("LastRetransmittedInterestDataDelay", MakeCallback (&PriConsumer::OnLastDelay, this));
+	}
+
+	if (m_countDeliveries)
+	{
+		Ptr<ForwardingStrategy> fw = GetNode ()->GetObject<ForwardingStrategy> ();
+		fw->TraceConnectWithoutContext ("InData", MakeCallback (&PriConsumer::OnNodeData, this));
+	}
+
+	// Epochs between handoffs and the window need the associations too
+	if (!m_pacing && !m_windowControl && !m_countDeliveries && m_histFile.empty ())
+		return;
+
+	Ptr<Node> node = GetNode ();
+	for (uint32_t i = 0; i < node->GetNDevices (); i++)
+	{
+		Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice> (node->GetDevice (i));
+		if (device == 0)
+			continue;
+
+		Ptr<StaWifiMac> mac = DynamicCast<StaWifiMac> (device->GetMac ());
+		if (mac == 0)
+			continue;
+
+		mac->TraceConnectWithoutContext ("Assoc", MakeCallback (&PriConsumer::OnAssoc, this));
+
+		if (m_pacing || m_windowControl)
+			mac->TraceConnectWithoutContext ("DeAssoc", MakeCallback (&PriConsumer::OnDeAssoc, this));
+	}
+}
+
+void
+PriConsumer::ScheduleNextPacket ()
+{
+	if (m_stopped)
+		return;
+
+	// Whatever is due goes out in the burst on reassociation
+	if (m_pacing && m_detached)
+	{
+		HoldNextPacket ();
+		return;
+	}
+
+	if (!m_windowControl)
+	{
+		ConsumerCbr::ScheduleNextPacket ();
+		return;
+	}
+
+	// Data or a timeout opens the window again
+	if (m_seqTimeouts.size () >= static_cast<uint32_t> (m_cwnd))
+		return;
+
+	if (!m_sendEvent.IsRunning ())
+		m_sendEvent = Simulator::ScheduleNow (&Consumer::SendPacket, this);
+}
+
+void
+PriConsumer::HoldNextPacket ()
+{
+	if (!m_active || m_sendEvent.IsRunning ())
+		return;
+
+	// Only what the consumer would have sent counts as held back
+	uint64_t left = m_retxSeqs.size ();
+	if (m_seq < m_seqMax)
+		left += m_seqMax - m_seq;
+
+	if (m_heldInterests >= left)
+		return;
+
+	if (m_windowControl && m_seqTimeouts.size () + m_heldInterests >= static_cast<uint32_t> (m_cwnd))
+		return;
+
+	Time gap = m_windowControl ? Seconds (0) : Seconds (1.0 / m_frequency);
+	m_sendEvent = Simulator::Schedule (gap, &PriConsumer::OnHeldInterest, this);
+}
+
+void
+PriConsumer::OnHeldInterest ()
+{
+	m_heldInterests++;
+	m_savedInterests++;
+
+	HoldNextPacket ();
+}
+
+void
+PriConsumer::StopTraffic ()
+{
+	m_stopped = true;
+	Simulator::Cancel (m_sendEvent);
+}
+
+double
+PriConsumer::GetWindow () const
+{
+	return m_cwnd;
+}
+
+void
+PriConsumer::IncreaseWindow ()
+{
+	if (m_cwnd < m_ssthresh)
+		m_cwnd += 1;
+	else
+		m_cwnd += 1 / m_cwnd;
+
+	m_cwnd = std::min<double> (m_cwnd, m_maxWindow);
+	m_windowTrace (this, m_cwnd);
+}
+
+void
+PriConsumer::DecreaseWindow (uint32_t sequenceNumber)
+{
+	Time now = Simulator::Now ();
+
+	// Sent before the path through the new access point was up
+	SeqTimeoutsContainer::index<i_seq>::type::iterator sent = m_seqLastDelay.get<i_seq> ().find (sequenceNumber);
+
+	if (m_detached || (sent != m_seqLastDelay.get<i_seq> ().end () && sent->time < m_attachTime + m_handoffGrace))
+	{
+		m_ignoredLosses++;
+		return;
+	}
+
+	// One loss event per RTT
+	if (now < m_lastDecrease + m_rtt->GetCurrentEstimate ())
+		return;
+
+	m_ssthresh = std::max (m_cwnd / 2, 1.0);
+	m_cwnd = m_ssthresh;
+	m_lastDecrease = now;
+
+	m_windowTrace (this, m_cwnd);
+}
+
+void
+PriConsumer::OnDeAssoc (Mac48Address ap)
+{
+	if (m_detached)
+		return;
+
+	m_detached = true;
+
+	if (m_pacing)
+		Simulator::Cancel (m_sendEvent);
+}
+
+void
+PriConsumer::OnAssoc (Mac48Address ap)
+{
+	// A new access point starts a new epoch
+	if (m_hasAp && ap != m_lastAp)
+	{
+		m_handoffs++;
+
+		if (!m_histFile.empty ())
+		{
+			RollWindow ();
+			Summarize ("epoch", m_epochIndex++, m_epoch);
+			m_epoch.start = Simulator::Now ();
+		}
+	}
+
+	m_hasAp = true;
+	m_lastAp = ap;
+
+	if (!m_detached)
+		return;
+
+	m_detached = false;
+	m_attachTime = Simulator::Now ();
+
+	if (!m_pacing)
+		return;
+
+	Simulator::Cancel (m_sendEvent);
+	m_heldInterests = 0;
+
+	// Fill the path for one RTT, the rest follows at Frequency
+	double pipe = std::ceil (m_rtt->GetCurrentEstimate ().GetSeconds () * m_frequency);
+	uint32_t burst = std::max<uint32_t> (1, std::min<double> (pipe, m_maxBurst));
+
+	if (m_windowControl)
+	{
+		uint32_t outstanding = m_seqTimeouts.size ();
+		uint32_t cwnd = static_cast<uint32_t> (m_cwnd);
+		burst = std::min (burst, cwnd > outstanding ? cwnd - outstanding : 0);
+	}
+
+	uint64_t sent = m_sentInterests;
+	for (uint32_t i = 0; i < burst && m_active && !m_stopped; i++)
+	{
+		SendPacket ();
+	}
+
+	uint32_t released = m_sentInterests - sent;
+	m_releasedInterests += released;
+	m_handoffRelease (this, released);
+
+	// Nothing left to release, carry on at Frequency
+	if (released == 0)
+		ScheduleNextPacket ();
+}
+
+uint64_t
+PriConsumer::GetSavedInterests () const
+{
+	return m_savedInterests;
+}
+
+uint64_t
+PriConsumer::GetReleasedInterests () const
+{
+	return m_releasedInterests;
+}
+
+void
+PriConsumer::StopApplication ()
+{
+	Simulator::Cancel (m_wheelEvent);
+	m_wheel.Clear ();
+
+	FlushHistograms ();
+
+	m_recorder.Close ();
+
+	ConsumerCbr::StopApplication ();
+}
+
+void
+PriConsumer::DoDispose ()
+{
+	// The simulation may have ended before StopTime
+	FlushHistograms ();
+	m_recorder.Close ();
+
+	ConsumerCbr::DoDispose ();
+}
+
+void
+PriConsumer::FlushHistograms ()
+{
+	if (m_histFile.empty () || !m_active)
+		return;
+
+	RollWindow ();
+	Summarize ("window", m_windowIndex, m_window);
+	Summarize ("epoch", m_epochIndex, m_epoch);
+	Summarize ("total", 0, m_total);
+	WriteHistograms ();
+}
+
+void
+PriConsumer::OnFirstDelay (Ptr<App> app, uint32_t seq, Time delay, uint32_t retxCount, int32_t hopCount)
+{
+	RollWindow ();
+
+	uint64_t us = delay.GetMicroSeconds ();
+
+	// The first transmission counts as one
+	uint32_t retx = retxCount > 0 ? retxCount - 1 : 0;
+
+	m_window.fullDelay.Record (us);
+	m_epoch.fullDelay.Record (us);
+	m_total.fullDelay.Record (us);
+
+	m_window.retx.Record (retx);
+	m_epoch.retx.Record (retx);
+	m_total.retx.Record (retx);
+}
+
+void
+PriConsumer::OnLastDelay (Ptr<App> app, uint32_t seq, Time delay, int32_t hopCount)
+{
+	RollWindow ();
+
+	uint64_t us = delay.GetMicroSeconds ();
+
+	m_window.lastDelay.Record (us);
+	m_epoch.lastDelay.Record (us);
+	m_total.lastDelay.Record (us);
+}
+
+void
+PriConsumer::RollWindow ()
+{
+	Time now = Simulator::Now ();
+
+	if (now < m_window.start + m_histWindow)
+		return;
+
+	Summarize ("window", m_windowIndex, m_window);
+
+	// Skip over the windows without any Data
+	int64_t passed = (now - m_window.start).GetInteger () / m_histWindow.GetInteger ();
+
+	m_windowIndex += passed;
+	m_window.start = Time (m_window.start.GetInteger () + passed * m_histWindow.GetInteger ());
+}
+
+void
+PriConsumer::Summarize (const std::string &scope, uint32_t index, DelayHistograms &hist)
 {
-	std::cout << "Entering PriConsumer GetSeqTimeout" << std::endl;
-	std::set<uint32_t> currSeqs;
-	uint32_t seqNo;
+	Summarize (scope, index, hist.start, "FullDelay", hist.fullDelay);
+	Summarize (scope, index, hist.start, "LastDelay", hist.lastDelay);
+	Summarize (scope, index, hist.start, "Retx", hist.retx);
 
+	hist.fullDelay.Reset ();
+	hist.lastDelay.Reset ();
+	hist.retx.Reset ();
+}
 
+void
+PriConsumer::Summarize (const std::string &scope, uint32_t index, Time start, const std::string &metric, const LogHistogram &hist)
+{
+	if (hist.IsEmpty ())
+		return;
 
-	std::cout << "Test the inheritance: " << m_seq << std::endl;
-	std::cout << "Does any of this make sense?" << std::endl;
-	uint32_t curr = m_seqTimeouts.size();
+	HistogramRow row;
+	row.scope = scope;
+	row.index = index;
+	row.start = start;
+	row.metric = metric;
+	row.count = hist.GetCount ();
+	row.mean = hist.GetMean ();
+	row.p50 = hist.GetPercentile (50);
+	row.p99 = hist.GetPercentile (99);
+	row.p999 = hist.GetPercentile (99.9);
+	row.max = hist.GetMax ();
 
-	std::cout << "I have a timeout size of: " << curr << std::endl;
+	m_histRows.push_back (row);
+}
 
-	SeqTimeoutsContainer::index<i_timestamp>::type::iterator entry = m_seqTimeouts.get<i_timestamp> ().begin ();
+void
+PriConsumer::WriteHistograms ()
+{
+	std::ofstream os (m_histFile.c_str ());
 
-	for (; entry != m_seqTimeouts.get<i_timestamp> ().end (); entry++ )
+	if (!os.is_open ())
 	{
-		std::cout << "Attempting a grab" << std::endl;
+		NS_LOG_UNCOND ("PriConsumer: cannot open " << m_histFile);
+		return;
+	}
 
-		seqNo = entry->seq;
+	// Delays in microseconds
+	os << "Node\tScope\tIndex\tStart\tMetric\tCount\tMean\tP50\tP99\tP99.9\tMax" << std::endl;
 
-		std::cout << "I have obtained a seq of: " << seqNo << " inserting..." << std::endl;
+	for (std::vector<HistogramRow>::iterator row = m_histRows.begin (); row != m_histRows.end (); ++row)
+	{
+		os << GetNode ()->GetId () << "\t"
+		   << row->scope << "\t"
+		   << row->index << "\t"
+		   << row->start.GetSeconds () << "\t"
+		   << row->metric << "\t"
+		   << row->count << "\t"
+		   << row->mean << "\t"
+		   << row->p50 << "\t"
+		   << row->p99 << "\t"
+		   << row->p999 << "\t"
+		   << row->max << std::endl;
+	}
 
-		currSeqs.insert(seqNo);
+	m_histRows.clear ();
+}
 
+void
+PriConsumer::WillSendOutInterest (uint32_t sequenceNumber)
+{
+	ConsumerCbr::WillSendOutInterest (sequenceNumber);
+	m_sentInterests++;
 
+	// Retransmissions are left to the replaying application
+	if (m_recorder.IsOpen () && m_seqRetxCounts[sequenceNumber] == 1)
+	{
+		if (!m_recorder.Write (Simulator::Now () - m_recordStart, m_interestName.toUri (), sequenceNumber))
+			NS_LOG_UNCOND ("PriConsumer: name too long to record " << m_interestName);
 	}
 
-	std::cout << "Returning from GetSeqTimeout" << std::endl;
+	if (!m_useWheel)
+		return;
+
+	m_wheel.Schedule (sequenceNumber, Simulator::Now () + m_rtt->RetransmitTimeout ());
+	ScheduleWheelTick ();
+}
+
+void
+PriConsumer::OnData (Ptr<const Data> data)
+{
+	if (!m_active)
+		return;
+
+	// Late answers for a content object already done with
+	if (m_contents > 0 && data->GetName ().getPrefix (data->GetName ().size () - 1) != m_interestName)
+	{
+		m_staleData++;
+		return;
+	}
+
+	ConsumerCbr::OnData (data);
+
+	uint32_t seq = data->GetName ().get (-1).toSeqNum ();
+
+	m_received.Insert (seq);
+	m_timedOut.Erase (seq);
+
+	if (m_useWheel)
+		m_wheel.Cancel (seq);
+
+	if (m_windowControl)
+		IncreaseWindow ();
+
+	if (m_contents > 0 && m_received.GetCount () >= m_seqMax)
+	{
+		m_completed++;
+		m_contentComplete (this, m_contentId, m_seqMax, Simulator::Now () - m_contentStart);
+
+		NextContent ();
+
+		// SendPacket stopped scheduling at the end of the previous one
+		ScheduleNextPacket ();
+	}
+	else if (m_windowControl)
+		ScheduleNextPacket ();
+}
+
+void
+PriConsumer::OnNodeData (Ptr<const Data> data, Ptr<const Face> face)
+{
+	// Only what came over the network, the application face is ours
+	if (face == m_face)
+		return;
+
+	const Name &name = data->GetName ();
+	uint64_t bytes = data->GetWire ()->GetSize ();
+
+	if (m_handoffDeliveries.size () <= m_handoffs)
+		m_handoffDeliveries.resize (m_handoffs + 1);
+
+	DeliveryCounters &epoch = m_handoffDeliveries[m_handoffs];
+
+	// Seen before OnData, so the copy that answers the Interest is not
+	// received yet
+	bool ours = name.size () > 0 && name.getPrefix (name.size () - 1) == m_interestName;
+	uint32_t seq = ours ? name.get (-1).toSeqNum () : 0;
+
+	if (ours && m_received.Contains (seq))
+	{
+		m_deliveries.duplicate++;
+		m_deliveries.duplicateBytes += bytes;
+		epoch.duplicate++;
+		epoch.duplicateBytes += bytes;
+		m_duplicateData (this, data);
+	}
+	else if (ours && m_seqTimeouts.get<i_seq> ().find (seq) != m_seqTimeouts.get<i_seq> ().end ())
+	{
+		m_deliveries.useful++;
+		m_deliveries.usefulBytes += bytes;
+		epoch.useful++;
+		epoch.usefulBytes += bytes;
+	}
+	else if (ours && m_timedOut.Contains (seq))
+	{
+		m_deliveries.late++;
+		m_deliveries.lateBytes += bytes;
+		epoch.late++;
+		epoch.lateBytes += bytes;
+		m_lateData (this, data);
+	}
+	else
+	{
+		m_deliveries.unsolicited++;
+		m_deliveries.unsolicitedBytes += bytes;
+		epoch.unsolicited++;
+		epoch.unsolicitedBytes += bytes;
+		m_unsolicitedData (this, data);
+	}
+}
+
+const DeliveryCounters &
+PriConsumer::GetDeliveries () const
+{
+	return m_deliveries;
+}
+
+const std::vector<DeliveryCounters> &
+PriConsumer::GetHandoffDeliveries () const
+{
+	return m_handoffDeliveries;
+}
+
+void
+PriConsumer::BuildCatalog ()
+{
+	m_zipfCdf.resize (m_contents);
+	m_contentChunks.resize (m_contents);
+
+	double sum = 0;
+	for (uint32_t i = 0; i < m_contents; i++)
+	{
+		sum += 1.0 / std::pow (i + 1, m_zipfAlpha);
+		m_zipfCdf[i] = sum;
+	}
+
+	for (uint32_t i = 0; i < m_contents; i++)
+		m_zipfCdf[i] /= sum;
+
+	// Same model as random/content-size-generator.cc, in bytes
+	boost::random::mt19937_64 gen (m_catalogSeed);
+	boost::random::geometric_distribution<uint64_t> size (1.0 / (m_avgContentSize * 1048576));
+
+	for (uint32_t i = 0; i < m_contents; i++)
+	{
+		uint64_t bytes = size (gen);
+		m_contentChunks[i] = std::max<uint64_t> (1, (bytes + m_chunkSize - 1) / m_chunkSize);
+	}
+}
+
+uint32_t
+PriConsumer::PickContent ()
+{
+	double p = m_zipfRng.GetValue ();
+
+	std::vector<double>::iterator it = std::lower_bound (m_zipfCdf.begin (), m_zipfCdf.end (), p);
+
+	if (it == m_zipfCdf.end ())
+		--it;
+
+	return it - m_zipfCdf.begin ();
+}
+
+void
+PriConsumer::NextContent ()
+{
+	m_contentId = PickContent ();
+	m_contentStart = Simulator::Now ();
+
+	m_interestName = m_basePrefix;
+	m_interestName.appendNumber (m_contentId);
+
+	m_seq = 0;
+	m_seqMax = m_contentChunks[m_contentId];
+
+	// Nothing of the previous content object is retransmitted
+	m_retxSeqs.clear ();
+	m_seqTimeouts.clear ();
+	m_seqLastDelay.clear ();
+	m_seqFullDelay.clear ();
+	m_seqRetxCounts.clear ();
+	m_rtt->ClearSent ();
+
+	m_wheel.Clear ();
+	m_received.Clear ();
+	m_timedOut.Clear ();
+}
+
+uint32_t
+PriConsumer::GetContentId () const
+{
+	return m_contentId;
+}
+
+uint64_t
+PriConsumer::GetCompletedContents () const
+{
+	return m_completed;
+}
+
+uint64_t
+PriConsumer::GetStaleData () const
+{
+	return m_staleData;
+}
+
+void
+PriConsumer::OnWheelTick ()
+{
+	m_expired.clear ();
+	m_wheel.Advance (Simulator::Now (), m_expired);
+
+	// Deadline order, oldest sequence number first on ties. OnTimeout
+	// queues them in m_retxSeqs, which SendPacket serves lowest first
+	for (std::vector<uint32_t>::iterator seq = m_expired.begin (); seq != m_expired.end (); ++seq)
+	{
+		if (m_seqTimeouts.erase (*seq) > 0)
+			OnTimeout (*seq);
+	}
+
+	ScheduleWheelTick ();
+}
+
+void
+PriConsumer::ScheduleWheelTick ()
+{
+	if (m_wheel.IsEmpty ())
+		return;
+
+	// Only wake up for the earliest deadline, a later one waits its turn
+	Time next = m_wheel.GetNextTick ();
+
+	if (m_wheelEvent.IsRunning ())
+	{
+		if (m_wheelWakeup <= next)
+			return;
+
+		Simulator::Cancel (m_wheelEvent);
+	}
+
+	Time now = Simulator::Now ();
+
+	m_wheelWakeup = next;
+	m_wheelEvent = Simulator::Schedule (next > now ? next - now : Seconds (0), &PriConsumer::OnWheelTick, this);
+}
+
+void
+PriConsumer::SetWheelTick (Time tick)
+{
+	m_wheel.Configure (tick, m_wheelSlots);
+}
+
+Time
+PriConsumer::GetWheelTick () const
+{
+	return m_wheel.GetTick ();
+}
+
+void
+PriConsumer::SetWheelSlots (uint32_t slots)
+{
+	m_wheelSlots = slots;
+	m_wheel.Configure (m_wheel.GetTick (), slots);
+}
+
+uint32_t
+PriConsumer::GetWheelSlots () const
+{
+	return m_wheelSlots;
+}
+
+SeqRangeSet
+PriConsumer::GetSeqTimeout ()
+{
+	SeqRangeSet currSeqs;
+
+	SeqTimeoutsContainer::index<i_seq>::type::iterator entry = m_seqTimeouts.get<i_seq> ().begin ();
+
+	for (; entry != m_seqTimeouts.get<i_seq> ().end (); entry++)
+	{
+		currSeqs.Insert (entry->seq);
+	}
 
 	return currSeqs;
 }
 
+const SeqRangeSet &
+PriConsumer::GetReceived () const
+{
+	return m_received;
+}
+
+const SeqRangeSet &
+PriConsumer::GetTimedOut () const
+{
+	return m_timedOut;
+}
+
+uint32_t
+PriConsumer::GetSeqTimeoutDelta (std::vector<uint32_t> &seqs)
+{
+	// Hand the log over and keep the caller's storage for the next one
+	seqs.clear ();
+	seqs.swap (m_timeoutLog);
+	m_logTimeouts = true;
+
+	return seqs.size ();
+}
+
+void
+PriConsumer::OnTimeout (uint32_t sequenceNumber)
+{
+	if (m_logTimeouts)
+		m_timeoutLog.push_back (sequenceNumber);
+
+	m_timedOut.Insert (sequenceNumber);
+
+	m_seqTimeout (this, sequenceNumber);
+
+	if (m_windowControl)
+		DecreaseWindow (sequenceNumber);
+
+	ConsumerCbr::OnTimeout (sequenceNumber);
+}
+
 } /* namespace ndn */
 } /* namespace ns3 */
@@ -8,7 +8,8 @@
 #ifndef NDN_PRICONSUMER_H_
 #define NDN_PRICONSUMER_H_
 
-#include <set>
+#include <string>
+#include <vector>
 
 #include <ns3-dev/ns3/ptr.h>
 #include <ns3-dev/ns3/log.h>
@@ -19,21 +20,301 @@
 #include <ns3-dev/ns3/boolean.h>
 #include <ns3-dev/ns3/uinteger.h>
 #include <ns3-dev/ns3/integer.h>
+#include <ns3-dev/ns3/mac48-address.h>
 #include <ns3-dev/ns3/double.h>
+#include <ns3-dev/ns3/random-variable.h>
+#include <ns3-dev/ns3/traced-callback.h>
 #include <ns3-dev/ns3/type-id.h>
 #include <ns3-dev/ns3/ndnSIM/model/ndn-name.h>
 #include <ns3-dev/ns3/ndnSIM/apps/ndn-consumer-cbr.h>
 
+#include "interest-schedule.h"
+#include "log-histogram.h"
+#include "seq-range-set.h"
+#include "seq-timer-wheel.h"
+
 namespace ns3 {
 namespace ndn {
 
+// Data reaching the consumer node over the network, by what it was worth
+struct DeliveryCounters {
+	DeliveryCounters ()
+	: useful (0), duplicate (0), late (0), unsolicited (0)
+	, usefulBytes (0), duplicateBytes (0), lateBytes (0), unsolicitedBytes (0)
+	{
+	}
+
+	uint64_t useful;           // Answered an outstanding Interest
+	uint64_t duplicate;        // Already received
+	uint64_t late;             // Timed out and not requested again yet
+	uint64_t unsolicited;      // Never requested
+	uint64_t usefulBytes;
+	uint64_t duplicateBytes;
+	uint64_t lateBytes;
+	uint64_t unsolicitedBytes;
+};
+
 class PriConsumer: public ConsumerCbr {
 public:
 	static TypeId GetTypeId ();
 
-	std::set<uint32_t>
+	PriConsumer ();
+
+	// Sequence numbers with an Interest outstanding
+	SeqRangeSet
 	GetSeqTimeout ();
 
+	// Sequence numbers whose Data was received
+	const SeqRangeSet &
+	GetReceived () const;
+
+	// Sequence numbers that timed out and were not received since
+	const SeqRangeSet &
+	GetTimedOut () const;
+
+	// Replace the contents of seqs with the sequence numbers that timed
+	// out since the previous call, in timeout order, and return how many. The
+	// first call only starts recording. Pass the same vector every time to
+	// reuse its storage
+	uint32_t
+	GetSeqTimeoutDelta (std::vector<uint32_t> &seqs);
+
+	virtual void
+	OnTimeout (uint32_t sequenceNumber);
+
+	virtual void
+	OnData (Ptr<const Data> data);
+
+	virtual void
+	WillSendOutInterest (uint32_t sequenceNumber);
+
+	// Interests not sent because the station was not associated
+	uint64_t
+	GetSavedInterests () const;
+
+	// Interests sent in the bursts released on reassociation
+	uint64_t
+	GetReleasedInterests () const;
+
+	// Stop sending Interests, Data still outstanding is received
+	void
+	StopTraffic ();
+
+	// Interests allowed in flight when WindowControl is set
+	double
+	GetWindow () const;
+
+	// Data delivered to the node when CountDeliveries is set
+	const DeliveryCounters &
+	GetDeliveries () const;
+
+	// The same, split at every association to a different access point
+	const std::vector<DeliveryCounters> &
+	GetHandoffDeliveries () const;
+
+	// Content object being fetched when Contents is set
+	uint32_t
+	GetContentId () const;
+
+	uint64_t
+	GetCompletedContents () const;
+
+	// Data of a content object fetched before the current one
+	uint64_t
+	GetStaleData () const;
+
+protected:
+	virtual void
+	StartApplication ();
+
+	virtual void
+	StopApplication ();
+
+	virtual void
+	DoDispose ();
+
+	// Hold Interests while detached from the access point, and while the
+	// window is full when WindowControl is set
+	virtual void
+	ScheduleNextPacket ();
+
+private:
+	void
+	OnAssoc (Mac48Address ap);
+
+	void
+	OnDeAssoc (Mac48Address ap);
+
+	// Count the Interests the consumer would have sent while detached
+	void
+	HoldNextPacket ();
+
+	void
+	OnHeldInterest ();
+
+	// Delays in microseconds and retransmission counts of one period
+	struct DelayHistograms {
+		Time start;
+		LogHistogram fullDelay;
+		LogHistogram lastDelay;
+		LogHistogram retx;
+	};
+
+	// Percentiles of one histogram over one period
+	struct HistogramRow {
+		std::string scope;
+		uint32_t index;
+		Time start;
+		std::string metric;
+		uint64_t count;
+		double mean;
+		uint64_t p50;
+		uint64_t p99;
+		uint64_t p999;
+		uint64_t max;
+	};
+
+	void
+	OnFirstDelay (Ptr<App> app, uint32_t seq, Time delay, uint32_t retxCount, int32_t hopCount);
+
+	void
+	OnLastDelay (Ptr<App> app, uint32_t seq, Time delay, int32_t hopCount);
+
+	// Close the current window if now is past it
+	void
+	RollWindow ();
+
+	void
+	Summarize (const std::string &scope, uint32_t index, DelayHistograms &hist);
+
+	void
+	Summarize (const std::string &scope, uint32_t index, Time start, const std::string &metric, const LogHistogram &hist);
+
+	void
+	WriteHistograms ();
+
+	// Close the open periods and write the file, once per run
+	void
+	FlushHistograms ();
+
+	// Classify every Data the node receives from the network
+	void
+	OnNodeData (Ptr<const Data> data, Ptr<const Face> face);
+
+	// Halve the window at most once per RTT, and not for Interests lost to
+	// a handoff
+	void
+	DecreaseWindow (uint32_t sequenceNumber);
+
+	void
+	IncreaseWindow ();
+
+	// Draw the size of every content object and the Zipf distribution
+	// over them
+	void
+	BuildCatalog ();
+
+	uint32_t
+	PickContent ();
+
+	// Drop the state of the current content object and start the next
+	void
+	NextContent ();
+
+	void
+	SetWheelTick (Time tick);
+
+	Time
+	GetWheelTick () const;
+
+	void
+	SetWheelSlots (uint32_t slots);
+
+	uint32_t
+	GetWheelSlots () const;
+
+	// Retransmit the sequence numbers whose deadline passed, replaces the
+	// periodic scan of CheckRetxTimeout
+	void
+	OnWheelTick ();
+
+	void
+	ScheduleWheelTick ();
+
+	bool m_useWheel;
+	uint32_t m_wheelSlots;
+	SeqTimerWheel m_wheel;
+	EventId m_wheelEvent;
+	Time m_wheelWakeup;
+	std::vector<uint32_t> m_expired;
+
+	bool m_pacing;
+	uint32_t m_maxBurst;
+	bool m_detached;
+	uint64_t m_savedInterests;
+	uint64_t m_releasedInterests;
+	uint64_t m_heldInterests;
+	uint64_t m_sentInterests;
+	TracedCallback<Ptr<App>, uint32_t> m_handoffRelease;
+	Time m_attachTime;
+	bool m_hasAp;
+	Mac48Address m_lastAp;
+	uint32_t m_handoffs;
+
+	bool m_countDeliveries;
+	DeliveryCounters m_deliveries;
+	std::vector<DeliveryCounters> m_handoffDeliveries;
+	TracedCallback<Ptr<App>, Ptr<const Data> > m_duplicateData;
+	TracedCallback<Ptr<App>, Ptr<const Data> > m_lateData;
+	TracedCallback<Ptr<App>, Ptr<const Data> > m_unsolicitedData;
+
+	std::string m_histFile;
+	Time m_histWindow;
+	uint32_t m_windowIndex;
+	uint32_t m_epochIndex;
+	DelayHistograms m_window;
+	DelayHistograms m_epoch;
+	DelayHistograms m_total;
+	std::vector<HistogramRow> m_histRows;
+
+	bool m_stopped;
+
+	std::string m_recordFile;
+	InterestScheduleWriter m_recorder;
+	Time m_recordStart;
+
+	bool m_windowControl;
+	uint32_t m_initialWindow;
+	uint32_t m_maxWindow;
+	Time m_handoffGrace;
+	double m_cwnd;
+	double m_ssthresh;
+	Time m_lastDecrease;
+	uint64_t m_ignoredLosses;
+	TracedCallback<Ptr<App>, double> m_windowTrace;
+
+	uint32_t m_contents;
+	double m_zipfAlpha;
+	double m_avgContentSize;
+	uint32_t m_chunkSize;
+	uint32_t m_catalogSeed;
+	std::vector<double> m_zipfCdf;
+	std::vector<uint32_t> m_contentChunks;
+	UniformVariable m_zipfRng;
+	Name m_basePrefix;
+	uint32_t m_contentId;
+	Time m_contentStart;
+	uint64_t m_completed;
+	uint64_t m_staleData;
+	TracedCallback<Ptr<App>, uint32_t, uint32_t, Time> m_contentComplete;
+
+	SeqRangeSet m_received;
+	SeqRangeSet m_timedOut;
+
+	bool m_logTimeouts;
+	std::vector<uint32_t> m_timeoutLog;
+
+	TracedCallback<Ptr<App>, uint32_t> m_seqTimeout;
 };
 
 } /* namespace ndn */
@@ -0,0 +1,286 @@
+/* -*- Mode:C++; c-file-style:"gnu"; -*- */
+/*
+ *
+ * Copyright (c) 2014 Waseda University, Sato Laboratory
+ * Author: Jairo Eduardo Lopez <jairo@ruri.waseda.jp>
+ *
+ *  ndn-replay-consumer.cc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  ndn-replay-consumer.cc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero Public License
+ *  along with ndn-replay-consumer.cc.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ndn-replay-consumer.h"
+
+#include <limits>
+
+#include <ns3-dev/ns3/double.h>
+#include <ns3-dev/ns3/log.h>
+#include <ns3-dev/ns3/packet.h>
+#include <ns3-dev/ns3/simulator.h>
+#include <ns3-dev/ns3/string.h>
+#include <ns3-dev/ns3/uinteger.h>
+#include <ns3-dev/ns3/ndnSIM/model/ndn-app-face.h>
+#include <ns3-dev/ns3/ndnSIM/model/ndn-data.h>
+#include <ns3-dev/ns3/ndnSIM/model/ndn-interest.h>
+#include <ns3-dev/ns3/ndnSIM/utils/ndn-fw-hop-count-tag.h>
+#include <ns3-dev/ns3/ndnSIM/utils/ndn-rtt-mean-deviation.h>
+
+NS_LOG_COMPONENT_DEFINE ("ndn.ReplayConsumer");
+
+namespace ns3 {
+namespace ndn {
+
+NS_OBJECT_ENSURE_REGISTERED (ReplayConsumer);
+
+TypeId
+ReplayConsumer::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ndn::ReplayConsumer")
+    .SetGroupName ("Ndn")
+    .SetParent<App> ()
+    .AddConstructor<ReplayConsumer> ()
+    .AddAttribute ("ScheduleFile", "Interest schedule to replay",
+                   StringValue (""),
+                   MakeStringAccessor (&ReplayConsumer::m_file),
+                   MakeStringChecker ())
+    .AddAttribute ("TimeScale", "Factor applied to the recorded times, below 1 sends faster",
+                   DoubleValue (1),
+                   MakeDoubleAccessor (&ReplayConsumer::m_timeScale),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("TimeOffset", "Delay added to every recorded time",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&ReplayConsumer::m_offset),
+                   MakeTimeChecker ())
+    .AddAttribute ("Prefix", "Prefix put in front of the recorded names, empty to keep them",
+                   StringValue (""),
+                   MakeStringAccessor (&ReplayConsumer::m_prefix),
+                   MakeStringChecker ())
+    .AddAttribute ("StripComponents", "Components removed from the front of the recorded names before adding Prefix",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&ReplayConsumer::m_strip),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("RetxTimeout", "Time to wait for the Data before sending the Interest again, 0 estimates it from the RTT",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&ReplayConsumer::m_retxTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxRetx", "Retransmissions of an Interest before giving up",
+                   UintegerValue (16),
+                   MakeUintegerAccessor (&ReplayConsumer::m_maxRetx),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("LifeTime", "LifeTime of the Interests",
+                   StringValue ("2s"),
+                   MakeTimeAccessor (&ReplayConsumer::m_lifetime),
+                   MakeTimeChecker ())
+    .AddTraceSource ("LastRetransmittedInterestDataDelay", "Delay between the last retransmitted Interest and the Data, the sequence number is the position in the schedule",
+                     MakeTraceSourceAccessor (&ReplayConsumer::m_lastRetransmittedInterestDataDelay))
+    .AddTraceSource ("FirstInterestDataDelay", "Delay between the first Interest and the Data, the sequence number is the position in the schedule",
+                     MakeTraceSourceAccessor (&ReplayConsumer::m_firstInterestDataDelay))
+    ;
+
+  return tid;
+}
+
+ReplayConsumer::ReplayConsumer ()
+	: m_timeScale (1)
+	, m_strip (0)
+	, m_retxTimeout (Seconds (0))
+	, m_maxRetx (16)
+	, m_lifetime (Seconds (2))
+	, m_rtt (CreateObject<RttMeanDeviation> ())
+	, m_rand (0, std::numeric_limits<uint32_t>::max ())
+	, m_sent (0)
+	, m_abandoned (0)
+{
+}
+
+void
+ReplayConsumer::StartApplication ()
+{
+	App::StartApplication ();
+
+	if (!m_reader.Open (m_file))
+		NS_FATAL_ERROR ("Cannot read the Interest schedule " << m_file);
+
+	m_start = Simulator::Now ();
+	ScheduleNext ();
+}
+
+void
+ReplayConsumer::StopApplication ()
+{
+	Finish ();
+
+	App::StopApplication ();
+}
+
+void
+ReplayConsumer::DoDispose ()
+{
+	// The simulation may have ended before StopTime
+	Finish ();
+
+	App::DoDispose ();
+}
+
+void
+ReplayConsumer::Finish ()
+{
+	Simulator::Cancel (m_nextEvent);
+
+	for (std::map<Name, Pending>::iterator it = m_pending.begin (); it != m_pending.end (); ++it)
+		Simulator::Cancel (it->second.timeout);
+
+	m_pending.clear ();
+	m_reader.Close ();
+}
+
+Time
+ReplayConsumer::GetRetxTimeout ()
+{
+	if (m_retxTimeout.IsStrictlyPositive ())
+		return m_retxTimeout;
+
+	return m_rtt->RetransmitTimeout ();
+}
+
+void
+ReplayConsumer::ScheduleNext ()
+{
+	Time time;
+	std::string prefix;
+	uint64_t seq;
+
+	if (!m_reader.Next (time, prefix, seq))
+		return;
+
+	Name name;
+	Name recorded (prefix);
+	recorded.appendSeqNum (seq);
+
+	if (m_prefix.empty ())
+		name = recorded;
+	else
+	{
+		name = Name (m_prefix);
+		if (m_strip < recorded.size ())
+			name.append (recorded.getSubName (m_strip));
+	}
+
+	Time at = m_start + m_offset + Seconds (time.GetSeconds () * m_timeScale);
+	Time now = Simulator::Now ();
+
+	m_nextEvent = Simulator::Schedule (at > now ? at - now : Seconds (0), &ReplayConsumer::SendRecorded, this, name);
+}
+
+void
+ReplayConsumer::SendRecorded (Name name)
+{
+	// A name still waiting for its Data is not sent again
+	if (m_pending.find (name) == m_pending.end ())
+	{
+		Pending &pending = m_pending[name];
+		pending.seq = m_sent++;
+		pending.count = 0;
+		pending.first = Simulator::Now ();
+
+		SendInterest (name, pending);
+	}
+
+	ScheduleNext ();
+}
+
+void
+ReplayConsumer::SendInterest (const Name &name, Pending &pending)
+{
+	if (!m_active)
+		return;
+
+	pending.count++;
+	pending.last = Simulator::Now ();
+
+	Ptr<Interest> interest = Create<Interest> ();
+	interest->SetNonce (m_rand.GetValue ());
+	interest->SetName (Create<Name> (name));
+	interest->SetInterestLifetime (m_lifetime);
+
+	NS_LOG_INFO ("> Interest for " << name);
+
+	m_transmittedInterests (interest, this, m_face);
+	m_face->ReceiveInterest (interest);
+
+	m_rtt->SentSeq (SequenceNumber32 (pending.seq), 1);
+	pending.timeout = Simulator::Schedule (GetRetxTimeout (), &ReplayConsumer::OnTimeout, this, name);
+}
+
+void
+ReplayConsumer::OnTimeout (Name name)
+{
+	std::map<Name, Pending>::iterator it = m_pending.find (name);
+	if (it == m_pending.end ())
+		return;
+
+	if (it->second.count > m_maxRetx)
+	{
+		m_abandoned++;
+		m_pending.erase (it);
+		return;
+	}
+
+	// Same backoff as Consumer
+	m_rtt->IncreaseMultiplier ();
+	SendInterest (name, it->second);
+}
+
+void
+ReplayConsumer::OnData (Ptr<const Data> data)
+{
+	if (!m_active)
+		return;
+
+	App::OnData (data);
+
+	std::map<Name, Pending>::iterator it = m_pending.find (data->GetName ());
+	if (it == m_pending.end ())
+		return;
+
+	NS_LOG_INFO ("< Data for " << data->GetName ());
+
+	int hopCount = -1;
+	FwHopCountTag hopCountTag;
+	if (data->GetPayload ()->PeekPacketTag (hopCountTag))
+		hopCount = hopCountTag.Get ();
+
+	Time now = Simulator::Now ();
+	const Pending &pending = it->second;
+
+	m_lastRetransmittedInterestDataDelay (this, pending.seq, now - pending.last, hopCount);
+	m_firstInterestDataDelay (this, pending.seq, now - pending.first, pending.count, hopCount);
+
+	m_rtt->AckSeq (SequenceNumber32 (pending.seq));
+
+	Simulator::Cancel (pending.timeout);
+	m_pending.erase (it);
+}
+
+uint64_t
+ReplayConsumer::GetSent () const
+{
+	return m_sent;
+}
+
+uint64_t
+ReplayConsumer::GetAbandoned () const
+{
+	return m_abandoned;
+}
+
+} /* namespace ndn */
+} /* namespace ns3 */
@@ -0,0 +1,130 @@
+/* -*- Mode:C++; c-file-style:"gnu"; -*- */
+/*
+ *
+ * Copyright (c) 2014 Waseda University, Sato Laboratory
+ * Author: Jairo Eduardo Lopez <jairo@ruri.waseda.jp>
+ *
+ *  ndn-replay-consumer.h is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  ndn-replay-consumer.h is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero Public License
+ *  along with ndn-replay-consumer.h.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NDN_REPLAY_CONSUMER_H_
+#define NDN_REPLAY_CONSUMER_H_
+
+#include <map>
+#include <string>
+
+#include <ns3-dev/ns3/ptr.h>
+#include <ns3-dev/ns3/nstime.h>
+#include <ns3-dev/ns3/random-variable.h>
+#include <ns3-dev/ns3/traced-callback.h>
+#include <ns3-dev/ns3/type-id.h>
+#include <ns3-dev/ns3/ndnSIM/apps/ndn-app.h>
+#include <ns3-dev/ns3/ndnSIM/model/ndn-name.h>
+#include <ns3-dev/ns3/ndnSIM/utils/ndn-rtt-estimator.h>
+
+#include "interest-schedule.h"
+
+namespace ns3 {
+namespace ndn {
+
+/**
+ * \brief Sends the Interests of a schedule recorded by PriConsumer
+ *
+ * The schedule is read one record ahead, so memory does not grow with its
+ * length. Each Interest is retransmitted until its Data arrives or MaxRetx
+ * is reached, after a timeout estimated from the RTT as Consumer does
+ * unless RetxTimeout is set. The delays are reported through the same
+ * trace sources as Consumer, which AppDelayTracer picks up.
+ */
+class ReplayConsumer: public App {
+public:
+	static TypeId GetTypeId ();
+
+	ReplayConsumer ();
+
+	virtual void
+	OnData (Ptr<const Data> data);
+
+	// Interests sent for the first time
+	uint64_t
+	GetSent () const;
+
+	// Interests given up after MaxRetx retransmissions
+	uint64_t
+	GetAbandoned () const;
+
+protected:
+	virtual void
+	StartApplication ();
+
+	virtual void
+	StopApplication ();
+
+	virtual void
+	DoDispose ();
+
+private:
+	struct Pending {
+		uint32_t seq;
+		uint32_t count;
+		Time first;
+		Time last;
+		EventId timeout;
+	};
+
+	// Read the next record and schedule it
+	void
+	ScheduleNext ();
+
+	void
+	SendRecorded (Name name);
+
+	void
+	SendInterest (const Name &name, Pending &pending);
+
+	void
+	OnTimeout (Name name);
+
+	// Drop the pending Interests and the schedule
+	void
+	Finish ();
+
+	Time
+	GetRetxTimeout ();
+
+	std::string m_file;
+	double m_timeScale;
+	Time m_offset;
+	std::string m_prefix;
+	uint32_t m_strip;
+	Time m_retxTimeout;
+	uint32_t m_maxRetx;
+	Time m_lifetime;
+	Ptr<RttEstimator> m_rtt;
+
+	InterestScheduleReader m_reader;
+	Time m_start;
+	EventId m_nextEvent;
+	UniformVariable m_rand;
+	std::map<Name, Pending> m_pending;
+	uint64_t m_sent;
+	uint64_t m_abandoned;
+
+	TracedCallback<Ptr<App>, uint32_t, Time, int32_t> m_lastRetransmittedInterestDataDelay;
+	TracedCallback<Ptr<App>, uint32_t, Time, uint32_t, int32_t> m_firstInterestDataDelay;
+};
+
+} /* namespace ndn */
+} /* namespace ns3 */
+
+#endif /* NDN_REPLAY_CONSUMER_H_ */
@@ -0,0 +1,216 @@
+/* -*- Mode:C++; c-file-style:"gnu"; -*- */
+/*
+ *
+ * Copyright (c) 2014 Waseda University, Sato Laboratory
+ * Author: Jairo Eduardo Lopez <jairo@ruri.waseda.jp>
+ *
+ *  redirect-buffer.cc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  redirect-buffer.cc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero Public License
+ *  along with redirect-buffer.cc.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "redirect-buffer.h"
+
+#include <algorithm>
+
+#include <ns3-dev/ns3/assert.h>
+#include <ns3-dev/ns3/packet.h>
+#include <ns3-dev/ns3/simulator.h>
+
+namespace ns3 {
+namespace ndn {
+namespace fw {
+
+RedirectBuffer::RedirectBuffer ()
+: m_size     (0)
+, m_bytes    (0)
+, m_capacity (10000)
+, m_maxAge   (Seconds (5))
+{
+}
+
+void
+RedirectBuffer::SetCapacity (uint32_t capacity)
+{
+  m_capacity = capacity;
+
+  while (m_size > m_capacity)
+    PopFront ();
+}
+
+uint32_t
+RedirectBuffer::GetCapacity () const
+{
+  return m_capacity;
+}
+
+void
+RedirectBuffer::SetMaxAge (Time maxAge)
+{
+  m_maxAge = maxAge;
+}
+
+Time
+RedirectBuffer::GetMaxAge () const
+{
+  return m_maxAge;
+}
+
+void
+RedirectBuffer::Push (const superData &item)
+{
+  if (m_capacity == 0)
+    return;
+
+  NS_ASSERT (item.data != 0);
+
+  Expire ();
+
+  Entry entry;
+  entry.arrival = Simulator::Now ();
+  entry.item = item;
+  entry.bytes = sizeof (Entry) + item.data->GetPayload ()->GetSize ();
+
+  // Collapse duplicates, keeping the faces the older copy was sent through
+  index::iterator dup = m_index.find (item.data->GetName ());
+  if (dup != m_index.end ())
+    {
+      entry.sentTo.swap (dup->second->sentTo);
+      Erase (dup->second);
+    }
+
+  // Make room for the new entry by dropping the oldest one
+  if (m_size >= m_capacity)
+    PopFront ();
+
+  m_entries.push_back (entry);
+  m_index[item.data->GetName ()] = --m_entries.end ();
+  m_size++;
+  m_bytes += entry.bytes;
+}
+
+RedirectBuffer::iterator
+RedirectBuffer::Find (const Name &name)
+{
+  index::iterator it = m_index.find (name);
+
+  if (it == m_index.end ())
+    return m_entries.end ();
+
+  return it->second;
+}
+
+bool
+RedirectBuffer::MarkSent (iterator entry, Ptr<Face> face)
+{
+  if (std::find (entry->sentTo.begin (), entry->sentTo.end (), face) != entry->sentTo.end ())
+    return false;
+
+  entry->sentTo.push_back (face);
+  return true;
+}
+
+void
+RedirectBuffer::Expire ()
+{
+  Time limit = Simulator::Now () - m_maxAge;
+
+  while (m_size > 0 && m_entries.front ().arrival < limit)
+    PopFront ();
+}
+
+RedirectBuffer::iterator
+RedirectBuffer::LowerBound (Time from)
+{
+  // Entries are appended in time order, and we are usually interested in
+  // the most recent ones, so walk backwards from the newest entry
+  container::reverse_iterator it = m_entries.rbegin ();
+
+  while (it != m_entries.rend () && it->arrival >= from)
+    ++it;
+
+  return it.base ();
+}
+
+RedirectBuffer::const_iterator
+RedirectBuffer::LowerBound (Time from) const
+{
+  container::const_reverse_iterator it = m_entries.rbegin ();
+
+  while (it != m_entries.rend () && it->arrival >= from)
+    ++it;
+
+  return it.base ();
+}
+
+RedirectBuffer::iterator
+RedirectBuffer::begin ()
+{
+  return m_entries.begin ();
+}
+
+RedirectBuffer::const_iterator
+RedirectBuffer::begin () const
+{
+  return m_entries.begin ();
+}
+
+RedirectBuffer::iterator
+RedirectBuffer::end ()
+{
+  return m_entries.end ();
+}
+
+RedirectBuffer::const_iterator
+RedirectBuffer::end () const
+{
+  return m_entries.end ();
+}
+
+uint32_t
+RedirectBuffer::GetSize () const
+{
+  return m_size;
+}
+
+uint64_t
+RedirectBuffer::GetBytes () const
+{
+  return m_bytes;
+}
+
+void
+RedirectBuffer::Erase (iterator entry)
+{
+  m_index.erase (entry->item.data->GetName ());
+  m_bytes -= entry->bytes;
+  m_entries.erase (entry);
+  m_size--;
+}
+
+void
+RedirectBuffer::Clear ()
+{
+  m_entries.clear ();
+  m_index.clear ();
+  m_size = 0;
+  m_bytes = 0;
+}
+
+void
+RedirectBuffer::PopFront ()
+{
+  Erase (m_entries.begin ());
+}
+
+} /* namespace fw */
+} /* namespace ndn */
+} /* namespace ns3 */
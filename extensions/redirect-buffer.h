@@ -0,0 +1,151 @@
+/* -*- Mode:C++; c-file-style:"gnu"; -*- */
+/*
+ *
+ * Copyright (c) 2014 Waseda University, Sato Laboratory
+ * Author: Jairo Eduardo Lopez <jairo@ruri.waseda.jp>
+ *
+ *  redirect-buffer.h is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  redirect-buffer.h is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero Public License
+ *  along with redirect-buffer.h.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REDIRECT_BUFFER_H_
+#define REDIRECT_BUFFER_H_
+
+#include <list>
+#include <map>
+#include <vector>
+
+#include <ns3-dev/ns3/ndnSIM/model/ndn-data.h>
+#include <ns3-dev/ns3/ndnSIM/model/ndn-face.h>
+#include <ns3-dev/ns3/ndnSIM/model/ndn-name.h>
+
+#include <ns3-dev/ns3/nstime.h>
+#include <ns3-dev/ns3/ptr.h>
+
+namespace ns3 {
+  namespace ndn {
+    namespace fw {
+
+      typedef struct {
+	Ptr<Face> inface;
+	Ptr<Face> outface;
+	Ptr<Data> data;
+      } superData;
+
+      /**
+       * \brief Time ordered buffer of Data kept for redirection
+       *
+       * Entries are kept in arrival order, so several Data arriving at the
+       * same simulation time are all kept. The buffer is bounded both in
+       * number of entries and in age; the oldest entries are evicted first.
+       *
+       * Entries are also indexed by Data name. A Data arriving with a name
+       * already in the buffer replaces the older entry, so the buffer holds
+       * at most one entry per name.
+       */
+      class RedirectBuffer {
+      public:
+	struct Entry {
+	  Time arrival;
+	  superData item;
+	  uint32_t bytes;
+	  // Faces this entry has already been flushed through
+	  std::vector<Ptr<Face> > sentTo;
+	};
+
+	typedef std::list<Entry> container;
+	typedef container::iterator iterator;
+	typedef container::const_iterator const_iterator;
+
+	RedirectBuffer ();
+
+	void
+	SetCapacity (uint32_t capacity);
+
+	uint32_t
+	GetCapacity () const;
+
+	void
+	SetMaxAge (Time maxAge);
+
+	Time
+	GetMaxAge () const;
+
+	// Add an entry stamped with the current simulation time, replacing
+	// any older entry for the same name
+	void
+	Push (const superData &item);
+
+	// Entry holding the Data with the name given, end () if none
+	iterator
+	Find (const Name &name);
+
+	// Record that the entry was sent through the face. Returns false if it
+	// had already been sent through it
+	bool
+	MarkSent (iterator entry, Ptr<Face> face);
+
+	// Evict all entries older than the maximum age
+	void
+	Expire ();
+
+	// First entry that arrived at or after the time given
+	iterator
+	LowerBound (Time from);
+
+	const_iterator
+	LowerBound (Time from) const;
+
+	iterator
+	begin ();
+
+	const_iterator
+	begin () const;
+
+	iterator
+	end ();
+
+	const_iterator
+	end () const;
+
+	uint32_t
+	GetSize () const;
+
+	// Approximate memory footprint of the buffered entries in bytes
+	uint64_t
+	GetBytes () const;
+
+	void
+	Erase (iterator entry);
+
+	void
+	Clear ();
+
+      private:
+	void
+	PopFront ();
+
+	typedef std::map<Name, iterator> index;
+
+	container m_entries;
+	index m_index;
+	uint32_t m_size;
+	uint64_t m_bytes;
+	uint32_t m_capacity;
+	Time m_maxAge;
+      };
+
+    } /* namespace fw */
+  } /* namespace ndn */
+} /* namespace ns3 */
+
+#endif /* REDIRECT_BUFFER_H_ */
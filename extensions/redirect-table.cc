@@ -0,0 +1,307 @@
+/* -*- Mode:C++; c-file-style:"gnu"; -*- */
+/*
+ *
+ * Copyright (c) 2014 Waseda University, Sato Laboratory
+ * Author: Jairo Eduardo Lopez <jairo@ruri.waseda.jp>
+ *
+ *  redirect-table.cc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  redirect-table.cc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero Public License
+ *  along with redirect-table.cc.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "redirect-table.h"
+
+#include <algorithm>
+
+namespace ns3 {
+namespace ndn {
+namespace fw {
+
+RedirectTable::RedirectTable ()
+: m_nodes (1)
+{
+  for (uint32_t k = 0; k < KINDS; k++)
+    m_size[k] = 0;
+}
+
+void
+RedirectTable::Add (const Name &prefix, uint32_t consumer, Ptr<Face> face, Kind kind, Time expiry)
+{
+  std::vector<Entry> &rules = m_nodes[Insert (prefix)].rules[kind];
+
+  for (std::vector<Entry>::iterator it = rules.begin (); it != rules.end (); ++it)
+    {
+      if (it->consumer == consumer && it->face == face)
+	{
+	  it->expiry = expiry;
+	  return;
+	}
+    }
+
+  Entry entry;
+  entry.consumer = consumer;
+  entry.face = face;
+  entry.expiry = expiry;
+  rules.push_back (entry);
+  m_size[kind]++;
+}
+
+bool
+RedirectTable::Remove (const Name &prefix, uint32_t consumer, Ptr<Face> face, Kind kind)
+{
+  TrieNode *node = Find (prefix);
+  if (node == 0)
+    return false;
+
+  std::vector<Entry> &rules = node->rules[kind];
+
+  for (std::vector<Entry>::iterator it = rules.begin (); it != rules.end (); ++it)
+    {
+      if (it->consumer == consumer && it->face == face)
+	{
+	  rules.erase (it);
+	  m_size[kind]--;
+	  return true;
+	}
+    }
+
+  return false;
+}
+
+uint32_t
+RedirectTable::Remove (const Name &prefix, uint32_t consumer, Kind kind)
+{
+  TrieNode *node = Find (prefix);
+  if (node == 0)
+    return 0;
+
+  std::vector<Entry> &rules = node->rules[kind];
+  uint32_t removed = 0;
+
+  for (std::vector<Entry>::iterator it = rules.begin (); it != rules.end (); )
+    {
+      if (it->consumer == consumer)
+	{
+	  it = rules.erase (it);
+	  removed++;
+	}
+      else
+	++it;
+    }
+
+  m_size[kind] -= removed;
+  return removed;
+}
+
+void
+RedirectTable::RemoveConsumer (uint32_t consumer)
+{
+  for (std::vector<TrieNode>::iterator node = m_nodes.begin (); node != m_nodes.end (); ++node)
+    {
+      for (uint32_t k = 0; k < KINDS; k++)
+	{
+	  std::vector<Entry> &rules = node->rules[k];
+
+	  for (std::vector<Entry>::iterator it = rules.begin (); it != rules.end (); )
+	    {
+	      if (it->consumer == consumer)
+		{
+		  it = rules.erase (it);
+		  m_size[k]--;
+		}
+	      else
+		++it;
+	    }
+	}
+    }
+}
+
+void
+RedirectTable::Clear (Kind kind)
+{
+  for (std::vector<TrieNode>::iterator node = m_nodes.begin (); node != m_nodes.end (); ++node)
+    node->rules[kind].clear ();
+
+  m_size[kind] = 0;
+
+  for (uint32_t k = 0; k < KINDS; k++)
+    {
+      if (m_size[k] > 0)
+	return;
+    }
+
+  // Nothing left, release the nodes
+  m_nodes.assign (1, TrieNode ());
+}
+
+void
+RedirectTable::Lookup (const Name &name, Kind kind, std::vector<Ptr<Face> > &faces) const
+{
+  if (m_size[kind] == 0)
+    return;
+
+  uint32_t node = 0;
+  Name::const_iterator component = name.begin ();
+
+  while (true)
+    {
+      const std::vector<Entry> &rules = m_nodes[node].rules[kind];
+
+      for (std::vector<Entry>::const_iterator it = rules.begin (); it != rules.end (); ++it)
+	{
+	  if (std::find (faces.begin (), faces.end (), it->face) == faces.end ())
+	    faces.push_back (it->face);
+	}
+
+      if (component == name.end ())
+	break;
+
+      std::map<name::Component, uint32_t>::const_iterator child = m_nodes[node].children.find (*component);
+      if (child == m_nodes[node].children.end ())
+	break;
+
+      node = child->second;
+      ++component;
+    }
+}
+
+bool
+RedirectTable::Matches (const Name &name, Kind kind) const
+{
+  if (m_size[kind] == 0)
+    return false;
+
+  uint32_t node = 0;
+  Name::const_iterator component = name.begin ();
+
+  while (m_nodes[node].rules[kind].empty ())
+    {
+      if (component == name.end ())
+	return false;
+
+      std::map<name::Component, uint32_t>::const_iterator child = m_nodes[node].children.find (*component);
+      if (child == m_nodes[node].children.end ())
+	return false;
+
+      node = child->second;
+      ++component;
+    }
+
+  return true;
+}
+
+Time
+RedirectTable::Expire (Time now, std::vector<Rule> &expired)
+{
+  Time next = Time::Max ();
+  Name root;
+
+  CollectExpired (0, root, now, next, expired);
+
+  return next;
+}
+
+uint32_t
+RedirectTable::GetSize (Kind kind) const
+{
+  return m_size[kind];
+}
+
+bool
+RedirectTable::IsEmpty (Kind kind) const
+{
+  return m_size[kind] == 0;
+}
+
+uint32_t
+RedirectTable::Insert (const Name &prefix)
+{
+  uint32_t node = 0;
+
+  for (Name::const_iterator component = prefix.begin (); component != prefix.end (); ++component)
+    {
+      std::map<name::Component, uint32_t>::iterator child = m_nodes[node].children.find (*component);
+
+      if (child != m_nodes[node].children.end ())
+	{
+	  node = child->second;
+	  continue;
+	}
+
+      // push_back may move the nodes, so only index into the vector after it
+      uint32_t created = m_nodes.size ();
+      m_nodes.push_back (TrieNode ());
+      m_nodes[node].children[*component] = created;
+      node = created;
+    }
+
+  return node;
+}
+
+RedirectTable::TrieNode *
+RedirectTable::Find (const Name &prefix)
+{
+  uint32_t node = 0;
+
+  for (Name::const_iterator component = prefix.begin (); component != prefix.end (); ++component)
+    {
+      std::map<name::Component, uint32_t>::iterator child = m_nodes[node].children.find (*component);
+
+      if (child == m_nodes[node].children.end ())
+	return 0;
+
+      node = child->second;
+    }
+
+  return &m_nodes[node];
+}
+
+void
+RedirectTable::CollectExpired (uint32_t node, Name &prefix, Time now, Time &next, std::vector<Rule> &expired)
+{
+  for (uint32_t k = 0; k < KINDS; k++)
+    {
+      std::vector<Entry> &rules = m_nodes[node].rules[k];
+
+      for (std::vector<Entry>::iterator it = rules.begin (); it != rules.end (); )
+	{
+	  if (it->expiry > now)
+	    {
+	      next = std::min (next, it->expiry);
+	      ++it;
+	      continue;
+	    }
+
+	  Rule rule;
+	  rule.prefix = prefix;
+	  rule.consumer = it->consumer;
+	  rule.face = it->face;
+	  rule.kind = static_cast<Kind> (k);
+	  rule.expiry = it->expiry;
+	  expired.push_back (rule);
+
+	  it = rules.erase (it);
+	  m_size[k]--;
+	}
+    }
+
+  for (std::map<name::Component, uint32_t>::iterator child = m_nodes[node].children.begin ();
+       child != m_nodes[node].children.end (); ++child)
+    {
+      Name sub = prefix;
+      sub.append (child->first);
+      CollectExpired (child->second, sub, now, next, expired);
+    }
+}
+
+} /* namespace fw */
+} /* namespace ndn */
+} /* namespace ns3 */
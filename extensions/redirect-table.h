@@ -0,0 +1,136 @@
+/* -*- Mode:C++; c-file-style:"gnu"; -*- */
+/*
+ *
+ * Copyright (c) 2014 Waseda University, Sato Laboratory
+ * Author: Jairo Eduardo Lopez <jairo@ruri.waseda.jp>
+ *
+ *  redirect-table.h is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  redirect-table.h is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero Public License
+ *  along with redirect-table.h.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REDIRECT_TABLE_H_
+#define REDIRECT_TABLE_H_
+
+#include <map>
+#include <vector>
+
+#include <ns3-dev/ns3/ndnSIM/model/ndn-face.h>
+#include <ns3-dev/ns3/ndnSIM/model/ndn-name.h>
+
+#include <ns3-dev/ns3/nstime.h>
+#include <ns3-dev/ns3/ptr.h>
+
+namespace ns3 {
+  namespace ndn {
+    namespace fw {
+
+      /**
+       * \brief Redirect rules keyed by name prefix and consumer
+       *
+       * Rules are stored in a trie of name components, so the rules that
+       * apply to a Data name are found by walking the name once. Each rule
+       * belongs to a consumer, which lets several mobiles hand off through
+       * the same router without touching each other's rules.
+       */
+      class RedirectTable {
+      public:
+	enum Kind {
+	  SECTOR = 0,   // Copy satisfied Data to the face
+	  DATA,         // Push unsolicited Data to the face
+	  KINDS
+	};
+
+	struct Rule {
+	  Name prefix;
+	  uint32_t consumer;
+	  Ptr<Face> face;
+	  Kind kind;
+	  Time expiry;
+	};
+
+	RedirectTable ();
+
+	// Add a rule, or renew the expiry of an existing one
+	void
+	Add (const Name &prefix, uint32_t consumer, Ptr<Face> face, Kind kind, Time expiry);
+
+	// Remove a rule. Returns false if there was none
+	bool
+	Remove (const Name &prefix, uint32_t consumer, Ptr<Face> face, Kind kind);
+
+	// Remove the rules of a consumer for a prefix, whatever their face.
+	// Returns the number of rules removed
+	uint32_t
+	Remove (const Name &prefix, uint32_t consumer, Kind kind);
+
+	// Remove all the rules of a consumer
+	void
+	RemoveConsumer (uint32_t consumer);
+
+	// Remove all the rules of a kind
+	void
+	Clear (Kind kind);
+
+	// Append the faces of the rules of a kind matching the name to faces,
+	// without duplicates
+	void
+	Lookup (const Name &name, Kind kind, std::vector<Ptr<Face> > &faces) const;
+
+	// True if a rule of the kind matches the name
+	bool
+	Matches (const Name &name, Kind kind) const;
+
+	// Remove the rules expired at now, appending them to expired. Returns
+	// the earliest expiry left, Time::Max () if none
+	Time
+	Expire (Time now, std::vector<Rule> &expired);
+
+	uint32_t
+	GetSize (Kind kind) const;
+
+	bool
+	IsEmpty (Kind kind) const;
+
+      private:
+	struct Entry {
+	  uint32_t consumer;
+	  Ptr<Face> face;
+	  Time expiry;
+	};
+
+	struct TrieNode {
+	  std::map<name::Component, uint32_t> children;
+	  std::vector<Entry> rules[KINDS];
+	};
+
+	// Node for the prefix, created if needed
+	uint32_t
+	Insert (const Name &prefix);
+
+	// Node for the prefix, 0 if it was never inserted
+	TrieNode *
+	Find (const Name &prefix);
+
+	void
+	CollectExpired (uint32_t node, Name &prefix, Time now, Time &next, std::vector<Rule> &expired);
+
+	// Nodes are kept in a vector and refer to their children by index,
+	// the root is at 0. Nodes are only released by clearing all rules
+	std::vector<TrieNode> m_nodes;
+	uint32_t m_size[KINDS];
+      };
+
+    } /* namespace fw */
+  } /* namespace ndn */
+} /* namespace ns3 */
+
+#endif /* REDIRECT_TABLE_H_ */
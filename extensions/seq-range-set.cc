@@ -0,0 +1,220 @@
+/* -*- Mode:C++; c-file-style:"gnu"; -*- */
+/*
+ *
+ * Copyright (c) 2014 Waseda University, Sato Laboratory
+ * Author: Jairo Eduardo Lopez <jairo@ruri.waseda.jp>
+ *
+ *  seq-range-set.cc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seq-range-set.cc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero Public License
+ *  along with seq-range-set.cc.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "seq-range-set.h"
+
+#include <algorithm>
+
+namespace ns3 {
+namespace ndn {
+
+SeqRangeSet::SeqRangeSet ()
+	: m_count (0)
+{
+}
+
+void
+SeqRangeSet::Insert (uint32_t seq)
+{
+	InsertRange (seq, (uint64_t) seq + 1);
+}
+
+void
+SeqRangeSet::Insert (uint32_t first, uint32_t last)
+{
+	if (first <= last)
+		InsertRange (first, (uint64_t) last + 1);
+}
+
+void
+SeqRangeSet::Erase (uint32_t seq)
+{
+	EraseRange (seq, (uint64_t) seq + 1);
+}
+
+void
+SeqRangeSet::Erase (uint32_t first, uint32_t last)
+{
+	if (first <= last)
+		EraseRange (first, (uint64_t) last + 1);
+}
+
+bool
+SeqRangeSet::Contains (uint32_t seq) const
+{
+	const_iterator it = m_ranges.upper_bound (seq);
+
+	if (it == m_ranges.begin ())
+		return false;
+
+	--it;
+	return seq < it->second;
+}
+
+void
+SeqRangeSet::Union (const SeqRangeSet &other)
+{
+	for (const_iterator it = other.begin (); it != other.end (); ++it)
+		InsertRange (it->first, it->second);
+}
+
+void
+SeqRangeSet::Difference (const SeqRangeSet &other)
+{
+	for (const_iterator it = other.begin (); it != other.end () && !m_ranges.empty (); ++it)
+		EraseRange (it->first, it->second);
+}
+
+uint64_t
+SeqRangeSet::GetCount () const
+{
+	return m_count;
+}
+
+uint32_t
+SeqRangeSet::GetRanges () const
+{
+	return m_ranges.size ();
+}
+
+uint64_t
+SeqRangeSet::GetFootprint () const
+{
+	// A red black tree node holds the value and three pointers plus colour
+	return sizeof (SeqRangeSet) + m_ranges.size () * (sizeof (container::value_type) + 4 * sizeof (void *));
+}
+
+bool
+SeqRangeSet::IsEmpty () const
+{
+	return m_ranges.empty ();
+}
+
+void
+SeqRangeSet::Clear ()
+{
+	m_ranges.clear ();
+	m_count = 0;
+}
+
+SeqRangeSet::const_iterator
+SeqRangeSet::begin () const
+{
+	return m_ranges.begin ();
+}
+
+SeqRangeSet::const_iterator
+SeqRangeSet::end () const
+{
+	return m_ranges.end ();
+}
+
+void
+SeqRangeSet::InsertRange (uint64_t start, uint64_t end)
+{
+	container::iterator it = m_ranges.upper_bound (start);
+
+	// Merge with a range starting before and touching the new one
+	if (it != m_ranges.begin ())
+	{
+		container::iterator prev = it;
+		--prev;
+
+		if (prev->second >= start)
+		{
+			if (prev->second >= end)
+				return;
+
+			start = prev->first;
+			end = std::max (end, prev->second);
+			m_count -= prev->second - prev->first;
+			m_ranges.erase (prev);
+		}
+	}
+
+	// And with the ranges it reaches
+	while (it != m_ranges.end () && it->first <= end)
+	{
+		end = std::max (end, it->second);
+		m_count -= it->second - it->first;
+		m_ranges.erase (it++);
+	}
+
+	m_ranges.insert (it, std::make_pair (start, end));
+	m_count += end - start;
+}
+
+void
+SeqRangeSet::EraseRange (uint64_t start, uint64_t end)
+{
+	container::iterator it = m_ranges.upper_bound (start);
+
+	if (it != m_ranges.begin ())
+		--it;
+
+	while (it != m_ranges.end () && it->first < end)
+	{
+		uint64_t first = it->first;
+		uint64_t last = it->second;
+
+		if (last <= start)
+		{
+			++it;
+			continue;
+		}
+
+		m_count -= last - first;
+		m_ranges.erase (it++);
+
+		// Keep what sticks out on either side
+		if (first < start)
+		{
+			m_ranges.insert (it, std::make_pair (first, start));
+			m_count += start - first;
+		}
+
+		if (last > end)
+		{
+			m_ranges.insert (it, std::make_pair (end, last));
+			m_count += last - end;
+		}
+	}
+}
+
+std::ostream &
+operator<< (std::ostream &os, const SeqRangeSet &set)
+{
+	bool first = true;
+
+	for (SeqRangeSet::const_iterator it = set.begin (); it != set.end (); ++it)
+	{
+		if (!first)
+			os << ' ';
+		first = false;
+
+		os << it->first;
+		if (it->second - it->first > 1)
+			os << '-' << it->second - 1;
+	}
+
+	return os;
+}
+
+} /* namespace ndn */
+} /* namespace ns3 */
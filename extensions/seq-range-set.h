@@ -0,0 +1,113 @@
+/* -*- Mode:C++; c-file-style:"gnu"; -*- */
+/*
+ *
+ * Copyright (c) 2014 Waseda University, Sato Laboratory
+ * Author: Jairo Eduardo Lopez <jairo@ruri.waseda.jp>
+ *
+ *  seq-range-set.h is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seq-range-set.h is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero Public License
+ *  along with seq-range-set.h.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SEQ_RANGE_SET_H_
+#define SEQ_RANGE_SET_H_
+
+#include <map>
+#include <ostream>
+
+#include <stdint.h>
+
+namespace ns3 {
+namespace ndn {
+
+/**
+ * \brief Set of sequence numbers stored as disjoint ranges
+ *
+ * Consecutive sequence numbers share a single entry, so the memory used
+ * depends on the number of gaps rather than on the number of sequence
+ * numbers. A download with a few holes costs a few entries whatever its
+ * size.
+ */
+class SeqRangeSet {
+public:
+	// Start of each range to one past its end
+	typedef std::map<uint64_t, uint64_t> container;
+	typedef container::const_iterator const_iterator;
+
+	SeqRangeSet ();
+
+	void
+	Insert (uint32_t seq);
+
+	// Insert first to last, both included
+	void
+	Insert (uint32_t first, uint32_t last);
+
+	void
+	Erase (uint32_t seq);
+
+	void
+	Erase (uint32_t first, uint32_t last);
+
+	bool
+	Contains (uint32_t seq) const;
+
+	// Add all the sequence numbers of other
+	void
+	Union (const SeqRangeSet &other);
+
+	// Remove all the sequence numbers of other
+	void
+	Difference (const SeqRangeSet &other);
+
+	// Number of sequence numbers held
+	uint64_t
+	GetCount () const;
+
+	// Number of disjoint ranges
+	uint32_t
+	GetRanges () const;
+
+	// Approximate memory used in bytes
+	uint64_t
+	GetFootprint () const;
+
+	bool
+	IsEmpty () const;
+
+	void
+	Clear ();
+
+	const_iterator
+	begin () const;
+
+	const_iterator
+	end () const;
+
+private:
+	void
+	InsertRange (uint64_t start, uint64_t end);
+
+	void
+	EraseRange (uint64_t start, uint64_t end);
+
+	container m_ranges;
+	uint64_t m_count;
+};
+
+// Prints the ranges as "a-b c d-e"
+std::ostream &
+operator<< (std::ostream &os, const SeqRangeSet &set);
+
+} /* namespace ndn */
+} /* namespace ns3 */
+
+#endif /* SEQ_RANGE_SET_H_ */
@@ -0,0 +1,222 @@
+/* -*- Mode:C++; c-file-style:"gnu"; -*- */
+/*
+ *
+ * Copyright (c) 2014 Waseda University, Sato Laboratory
+ * Author: Jairo Eduardo Lopez <jairo@ruri.waseda.jp>
+ *
+ *  seq-timer-wheel.cc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seq-timer-wheel.cc is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero Public License
+ *  along with seq-timer-wheel.cc.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "seq-timer-wheel.h"
+
+#include <algorithm>
+#include <limits>
+
+#include <ns3-dev/ns3/assert.h>
+
+namespace ns3 {
+namespace ndn {
+
+static const int64_t NO_TICK = std::numeric_limits<int64_t>::max ();
+
+SeqTimerWheel::SeqTimerWheel ()
+	: m_current (0)
+	, m_next (NO_TICK)
+{
+	Configure (MilliSeconds (5), 512);
+}
+
+void
+SeqTimerWheel::Configure (Time tick, uint32_t slots)
+{
+	NS_ASSERT (tick.IsStrictlyPositive () && slots > 0);
+
+	m_tick = tick;
+	m_slots.assign (slots, std::vector<Timer> ());
+	m_deadlines.clear ();
+	m_current = 0;
+	m_next = NO_TICK;
+}
+
+Time
+SeqTimerWheel::GetTick () const
+{
+	return m_tick;
+}
+
+void
+SeqTimerWheel::Schedule (uint32_t seq, Time deadline)
+{
+	Timer timer;
+	timer.seq = seq;
+	timer.tick = std::max (ToTick (deadline), m_current + 1);
+
+	m_deadlines[seq] = timer.tick;
+	m_slots[timer.tick % m_slots.size ()].push_back (timer);
+
+	m_next = std::min (m_next, timer.tick);
+}
+
+void
+SeqTimerWheel::Cancel (uint32_t seq)
+{
+	m_deadlines.erase (seq);
+
+	if (m_deadlines.empty ())
+		m_next = NO_TICK;
+}
+
+void
+SeqTimerWheel::Advance (Time now, std::vector<uint32_t> &expired)
+{
+	int64_t target = now.GetInteger () / m_tick.GetInteger ();
+
+	if (target <= m_current)
+		return;
+
+	// Nothing can be due yet, the slots passed are cleaned on a later turn
+	if (target < m_next)
+	{
+		m_current = target;
+		return;
+	}
+
+	// Past a full turn every slot has to be visited once anyway
+	int64_t first = std::max (m_current + 1, target - (int64_t) m_slots.size () + 1);
+
+	m_due.clear ();
+
+	for (int64_t t = first; t <= target; t++)
+	{
+		std::vector<Timer> &slot = m_slots[t % m_slots.size ()];
+
+		for (std::vector<Timer>::iterator it = slot.begin (); it != slot.end (); )
+		{
+			deadline_map::iterator live = m_deadlines.find (it->seq);
+
+			if (live == m_deadlines.end () || live->second != it->tick)
+			{
+				// Cancelled or rescheduled
+				*it = slot.back ();
+				slot.pop_back ();
+				continue;
+			}
+
+			if (it->tick > target)
+			{
+				// Due in a later turn of the wheel
+				++it;
+				continue;
+			}
+
+			m_due.push_back (*it);
+			m_deadlines.erase (live);
+
+			*it = slot.back ();
+			slot.pop_back ();
+		}
+	}
+
+	m_current = target;
+	FindNext ();
+
+	std::sort (m_due.begin (), m_due.end ());
+
+	for (std::vector<Timer>::iterator it = m_due.begin (); it != m_due.end (); ++it)
+		expired.push_back (it->seq);
+}
+
+Time
+SeqTimerWheel::GetNextTick () const
+{
+	if (m_next == NO_TICK)
+		return Time::Max ();
+
+	return Time (m_next * m_tick.GetInteger ());
+}
+
+uint32_t
+SeqTimerWheel::GetSize () const
+{
+	return m_deadlines.size ();
+}
+
+bool
+SeqTimerWheel::IsEmpty () const
+{
+	return m_deadlines.empty ();
+}
+
+void
+SeqTimerWheel::Clear ()
+{
+	for (std::vector<std::vector<Timer> >::iterator slot = m_slots.begin (); slot != m_slots.end (); ++slot)
+		slot->clear ();
+
+	m_deadlines.clear ();
+	m_next = NO_TICK;
+}
+
+int64_t
+SeqTimerWheel::ToTick (Time t) const
+{
+	// Round up, a timer never fires before its deadline
+	return (t.GetInteger () + m_tick.GetInteger () - 1) / m_tick.GetInteger ();
+}
+
+bool
+SeqTimerWheel::Purge (std::vector<Timer> &slot)
+{
+	for (std::vector<Timer>::iterator it = slot.begin (); it != slot.end (); )
+	{
+		deadline_map::const_iterator live = m_deadlines.find (it->seq);
+
+		if (live == m_deadlines.end () || live->second != it->tick)
+		{
+			*it = slot.back ();
+			slot.pop_back ();
+			continue;
+		}
+
+		++it;
+	}
+
+	return !slot.empty ();
+}
+
+void
+SeqTimerWheel::FindNext ()
+{
+	m_next = NO_TICK;
+
+	if (m_deadlines.empty ())
+		return;
+
+	int64_t last = m_current + (int64_t) m_slots.size ();
+
+	// A live timer in slot t is due at t or a whole number of turns later,
+	// so the scan stops once it passes the earliest deadline found
+	for (int64_t t = m_current + 1; t <= last && t < m_next; t++)
+	{
+		std::vector<Timer> &slot = m_slots[t % m_slots.size ()];
+
+		if (!Purge (slot))
+			continue;
+
+		for (std::vector<Timer>::iterator it = slot.begin (); it != slot.end (); ++it)
+			m_next = std::min (m_next, it->tick);
+	}
+}
+
+} /* namespace ndn */
+} /* namespace ns3 */
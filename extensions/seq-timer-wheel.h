@@ -0,0 +1,118 @@
+/* -*- Mode:C++; c-file-style:"gnu"; -*- */
+/*
+ *
+ * Copyright (c) 2014 Waseda University, Sato Laboratory
+ * Author: Jairo Eduardo Lopez <jairo@ruri.waseda.jp>
+ *
+ *  seq-timer-wheel.h is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  seq-timer-wheel.h is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero Public License
+ *  along with seq-timer-wheel.h.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SEQ_TIMER_WHEEL_H_
+#define SEQ_TIMER_WHEEL_H_
+
+#include <vector>
+
+#include <boost/unordered_map.hpp>
+
+#include <ns3-dev/ns3/nstime.h>
+
+namespace ns3 {
+namespace ndn {
+
+/**
+ * \brief Hashed timer wheel of per sequence number deadlines
+ *
+ * Deadlines are rounded up to a tick and hashed into a fixed number of
+ * slots, so scheduling is O(1) and advancing costs the timers in the slots
+ * passed. Rescheduling or cancelling a sequence number leaves its old timer
+ * in place; it is recognised as stale and dropped when its slot is visited.
+ * The earliest deadline is tracked, so the owner only needs to wake up when
+ * a timer can actually be due.
+ */
+class SeqTimerWheel {
+public:
+	SeqTimerWheel ();
+
+	// Drops all the timers
+	void
+	Configure (Time tick, uint32_t slots);
+
+	Time
+	GetTick () const;
+
+	// Set the deadline of the sequence number, replacing any previous one
+	void
+	Schedule (uint32_t seq, Time deadline);
+
+	void
+	Cancel (uint32_t seq);
+
+	// Append the sequence numbers whose deadline is at or before now to
+	// expired, in deadline order and lowest sequence number first on ties
+	void
+	Advance (Time now, std::vector<uint32_t> &expired);
+
+	// Time of the tick of the earliest deadline, Advance finds nothing
+	// before it. May be early after a Cancel, never late
+	Time
+	GetNextTick () const;
+
+	uint32_t
+	GetSize () const;
+
+	bool
+	IsEmpty () const;
+
+	void
+	Clear ();
+
+private:
+	struct Timer {
+		uint32_t seq;
+		int64_t tick;
+
+		bool
+		operator< (const Timer &other) const
+		{
+			return tick < other.tick || (tick == other.tick && seq < other.seq);
+		}
+	};
+
+	typedef boost::unordered_map<uint32_t, int64_t> deadline_map;
+
+	int64_t
+	ToTick (Time t) const;
+
+	// Drop the stale timers of the slot, returns true if it still holds any
+	bool
+	Purge (std::vector<Timer> &slot);
+
+	// Earliest live deadline after the current tick, scanning at most a turn
+	void
+	FindNext ();
+
+	Time m_tick;
+	std::vector<std::vector<Timer> > m_slots;
+	// Live deadline, in ticks, of each scheduled sequence number
+	deadline_map m_deadlines;
+	// Last tick Advance went through
+	int64_t m_current;
+	// Lower bound of the earliest live deadline
+	int64_t m_next;
+	std::vector<Timer> m_due;
+};
+
+} /* namespace ndn */
+} /* namespace ns3 */
+
+#endif /* SEQ_TIMER_WHEEL_H_ */
@@ -21,6 +21,10 @@
 
 #include "smart-flooding-inf.h"
 
+#include <cmath>
+
+#include <ns3-dev/ns3/ndnSIM/utils/ndn-fw-hop-count-tag.h>
+
 namespace ns3 {
 namespace ndn {
 namespace fw {
@@ -29,6 +33,16 @@ NS_OBJECT_ENSURE_REGISTERED (SmartFloodingInf);
 
 NS_LOG_COMPONENT_DEFINE ("SmartFloodingInf");
 
+// Name of a Data without its sequence number
+static Name
+GetStreamPrefix (const Name &name)
+{
+  if (name.size () == 0)
+    return name;
+
+  return name.getPrefix (name.size () - 1);
+}
+
 TypeId
 SmartFloodingInf::GetTypeId (void)
 {
@@ -36,6 +50,66 @@ SmartFloodingInf::GetTypeId (void)
 		       .SetGroupName ("Ndn")
 		       .SetParent <SmartFlooding> ()
 		       .AddConstructor <SmartFloodingInf> ()
+		       .AddAttribute ("BufferCapacity", "Maximum number of Data entries kept for redirection",
+				      UintegerValue (10000),
+				      MakeUintegerAccessor (&SmartFloodingInf::SetBufferCapacity,
+							    &SmartFloodingInf::GetBufferCapacity),
+				      MakeUintegerChecker<uint32_t> ())
+		       .AddAttribute ("BufferMaxAge", "Maximum time a Data entry is kept for redirection",
+				      TimeValue (Seconds (5)),
+				      MakeTimeAccessor (&SmartFloodingInf::SetBufferMaxAge,
+							&SmartFloodingInf::GetBufferMaxAge),
+				      MakeTimeChecker ())
+		       .AddAttribute ("FlushBurst", "Number of Data sent per event when flushing the buffer, 0 sends everything at once",
+				      UintegerValue (8),
+				      MakeUintegerAccessor (&SmartFloodingInf::m_flushBurst),
+				      MakeUintegerChecker<uint32_t> ())
+		       .AddAttribute ("FlushInterval", "Time between two bursts when flushing the buffer",
+				      TimeValue (MilliSeconds (2)),
+				      MakeTimeAccessor (&SmartFloodingInf::m_flushInterval),
+				      MakeTimeChecker ())
+		       .AddAttribute ("FlushStopOnCatchUp", "Stop flushing once the consumer has an Interest pending for the buffered Data",
+				      BooleanValue (true),
+				      MakeBooleanAccessor (&SmartFloodingInf::m_flushStopOnCatchUp),
+				      MakeBooleanChecker ())
+		       .AddAttribute ("RedirectStoreSize", "Entries in the Content Store partition for redirected Data, 0 uses the main Content Store",
+				      UintegerValue (0),
+				      MakeUintegerAccessor (&SmartFloodingInf::SetRedirectStoreSize,
+							    &SmartFloodingInf::GetRedirectStoreSize),
+				      MakeUintegerChecker<uint32_t> ())
+		       .AddAttribute ("RedirectAdmitWindow", "Only cache redirected Data within this many sequence numbers of the newest one, 0 admits all",
+				      UintegerValue (0),
+				      MakeUintegerAccessor (&SmartFloodingInf::m_redirectAdmitWindow),
+				      MakeUintegerChecker<uint32_t> ())
+		       .AddAttribute ("RedirectLease", "How long a redirect rule stays on unless renewed, 0 keeps it until removed",
+				      TimeValue (Seconds (0)),
+				      MakeTimeAccessor (&SmartFloodingInf::m_lease),
+				      MakeTimeChecker ())
+		       .AddAttribute ("AdaptiveReplay", "Size the replay window from measured RTTs instead of m_rtx",
+				      BooleanValue (true),
+				      MakeBooleanAccessor (&SmartFloodingInf::m_adaptiveReplay),
+				      MakeBooleanChecker ())
+
+		       .AddTraceSource ("BufferedData", "Data added to the redirect buffer",
+					MakeTraceSourceAccessor (&SmartFloodingInf::m_bufferedData))
+		       .AddTraceSource ("RedirectedData", "Data sent through a redirect face",
+					MakeTraceSourceAccessor (&SmartFloodingInf::m_redirectedData))
+		       .AddTraceSource ("PassthroughData", "Unsolicited Data pushed through by an edge node",
+					MakeTraceSourceAccessor (&SmartFloodingInf::m_passthroughData))
+		       .AddTraceSource ("RedirectDrop", "Redirected or flushed Data the face refused",
+					MakeTraceSourceAccessor (&SmartFloodingInf::m_redirectDrop))
+		       .AddTraceSource ("FlushStart", "Buffer flush started through a face",
+					MakeTraceSourceAccessor (&SmartFloodingInf::m_flushStart))
+		       .AddTraceSource ("FlushEnd", "Buffer flush through a face finished",
+					MakeTraceSourceAccessor (&SmartFloodingInf::m_flushEnd))
+		       .AddTraceSource ("BufferOccupancy", "Entries and bytes held in the redirect buffer",
+					MakeTraceSourceAccessor (&SmartFloodingInf::m_bufferOccupancy))
+		       .AddTraceSource ("PrepushedData", "Unsolicited Data cached ahead of a handoff",
+					MakeTraceSourceAccessor (&SmartFloodingInf::m_prepushedData))
+		       .AddTraceSource ("PrepushUsed", "Pre-pushed Data served from the cache, with the time it waited",
+					MakeTraceSourceAccessor (&SmartFloodingInf::m_prepushUsed))
+		       .AddTraceSource ("RedirectExpired", "Redirect rule removed because its lease ran out",
+					MakeTraceSourceAccessor (&SmartFloodingInf::m_redirectExpired))
 		       ;
   return tid;
 }
@@ -46,6 +120,17 @@ SmartFloodingInf::SmartFloodingInf()
 , m_redirect      (false)
 , m_data_redirect (false)
 , m_edge          (false)
+, m_passthrough   (false)
+, m_prepush       (false)
+, m_flushBurst    (8)
+, m_flushInterval (MilliSeconds (2))
+, m_flushStopOnCatchUp (true)
+, m_adaptiveReplay (true)
+, m_redirectStoreSize (0)
+, m_redirectAdmitWindow (0)
+, m_cacheTraced   (false)
+, m_partitionMissed (false)
+, m_lease         (Seconds (0))
 {
 }
 
@@ -59,8 +144,20 @@ SmartFloodingInf::SatisfyPendingInterest (Ptr<Face> inFace, Ptr<const Data> data
 {
   if (inFace != 0)
     pitEntry->RemoveIncoming (inFace);
+  else if (m_prepushed.GetSize () > 0)
+    {
+      // Served from the cache, check whether it got there by a pre-push
+      RedirectBuffer::iterator pre = m_prepushed.Find (data->GetName ());
+      if (pre != m_prepushed.end ())
+	{
+	  m_counters.prepushUsed++;
+	  m_prepushUsed (data, Simulator::Now () - pre->arrival);
+	  m_prepushed.Erase (pre);
+	}
+    }
 
-  std::set<Ptr<Face> > seen_face;
+  // Faces seen while satisfying, kept on the stack
+  FaceMask seen_face;
 
   //satisfy all pending incoming Interests
   BOOST_FOREACH (const pit::IncomingFace &incoming, pitEntry->GetIncoming ())
@@ -77,36 +174,32 @@ SmartFloodingInf::SatisfyPendingInterest (Ptr<Face> inFace, Ptr<const Data> data
       }
 
     // Keep list of Faces seen to later check
-    seen_face.insert(incoming.m_face);
+    seen_face.Set (incoming.m_face);
   }
-  Time now = Simulator::Now ();
 
   // Check if we have the redirect turned on
   if (m_redirect) {
 
-      // Iterator
-      std::set<Ptr<Face> >::iterator it;
+      // Borrow the scratch vector, a nested call finds it empty
+      std::vector<Ptr<Face> > faces;
+      faces.swap (m_redirectScratch);
+      faces.clear ();
 
-      // Place to keep the difference of the set we have and what we have seen
-      std::set<Ptr<Face> > diff;
+      m_redirects.Lookup (data->GetName (), RedirectTable::SECTOR, faces);
 
-      std::set_difference(redirectFaces.begin(), redirectFaces.end(), seen_face.begin(), seen_face.end(),
-			  std::inserter(diff, diff.begin()));
+      // Send to the redirect faces we have not already satisfied
+      BOOST_FOREACH (Ptr<Face> touse, faces)
+      {
+	if (seen_face.Test (touse))
+	  continue;
 
-      for (it = diff.begin(); it != diff.end(); it++)
-	{
-	  Ptr<Face> touse = (*it);
-	  bool ok = touse->SendData (data);
+	if (seen_face.HasOverflow () && pitEntry->GetIncoming ().find (touse) != pitEntry->GetIncoming ().end ())
+	  continue;
 
-	  DidSendOutData (inFace, touse, data, pitEntry);
-	  NS_LOG_DEBUG ("Satisfy " << touse);
+	SendRedirected (inFace, touse, data, pitEntry);
+      }
 
-	  if (!ok)
-	    {
-	      m_dropData (data, touse);
-	      NS_LOG_DEBUG ("Cannot satisfy data to " << touse);
-	    }
-	}
+      faces.swap (m_redirectScratch);
   }
 
   // All incoming interests are satisfied. Remove them
@@ -119,6 +212,76 @@ SmartFloodingInf::SatisfyPendingInterest (Ptr<Face> inFace, Ptr<const Data> data
   m_pit->MarkErased (pitEntry);
 }
 
+void
+SmartFloodingInf::NotifyNewAggregate ()
+{
+  super::NotifyNewAggregate ();
+
+  if (!m_cacheTraced && m_contentStore != 0)
+    {
+      m_contentStore->TraceConnectWithoutContext ("CacheHits", MakeCallback (&SmartFloodingInf::CountCacheHit, this));
+      m_contentStore->TraceConnectWithoutContext ("CacheMisses", MakeCallback (&SmartFloodingInf::CountCacheMiss, this));
+      m_cacheTraced = true;
+    }
+}
+
+// Serve Interests from the redirect partition before anything else. A hit
+// goes through the same steps as a Content Store hit in
+// ForwardingStrategy::OnInterest
+void
+SmartFloodingInf::OnInterest (Ptr<Face> inFace, Ptr<Interest> interest)
+{
+  Ptr<Data> data;
+  if (m_redirectStore != 0)
+    data = m_redirectStore->Lookup (interest);
+
+  if (data == 0)
+    {
+      // The miss is counted once the Interest gets past the duplicate
+      // check to the main Content Store, as the hits are
+      m_partitionMissed = (m_redirectStore != 0);
+      super::OnInterest (inFace, interest);
+      m_partitionMissed = false;
+      return;
+    }
+
+  m_inInterests (interest, inFace);
+
+  Ptr<pit::Entry> pitEntry = m_pit->Lookup (*interest);
+  if (pitEntry == 0)
+    {
+      pitEntry = m_pit->Create (interest);
+      if (pitEntry != 0)
+	DidCreatePitEntry (inFace, interest, pitEntry);
+      else
+	{
+	  FailedToCreatePitEntry (inFace, interest);
+	  return;
+	}
+    }
+
+  if (pitEntry->IsNonceSeen (interest->GetNonce ()))
+    {
+      DidReceiveDuplicateInterest (inFace, interest, pitEntry);
+      return;
+    }
+
+  pitEntry->AddSeenNonce (interest->GetNonce ());
+
+  NS_LOG_DEBUG ("Redirect partition hit for " << interest->GetName ());
+  m_counters.redirectStore.hits++;
+
+  FwHopCountTag hopCountTag;
+  if (interest->GetPayload ()->PeekPacketTag (hopCountTag))
+    data->GetPayload ()->AddPacketTag (hopCountTag);
+
+  pitEntry->AddIncoming (inFace);
+
+  // Same as a Content Store hit
+  WillSatisfyPendingInterest (0, pitEntry);
+  SatisfyPendingInterest (0, data, pitEntry);
+}
+
 // Reimplementation on obtaining Data
 void
 SmartFloodingInf::OnData (Ptr<Face> inFace, Ptr<Data> data)
@@ -126,113 +289,45 @@ SmartFloodingInf::OnData (Ptr<Face> inFace, Ptr<Data> data)
   NS_LOG_FUNCTION (inFace << data->GetName ());
   m_inData (data, inFace);
 
-  Time now = Simulator::Now ();
-
-  // Iterator
-  std::set<Ptr<Face> >::iterator it;
-
   // Lookup PIT entry
   Ptr<pit::Entry> pitEntry = m_pit->Lookup (*data);
   if (pitEntry == 0)
     {
+      if (m_prepush)
+	{
+	  AdmitPrepushed (inFace, data);
+
+	  if (!m_data_redirect)
+	    return;
+	}
 
       if (m_data_redirect)
 	{
-	  // Add to content store
-	  m_contentStore->Add (data);
+	  // Add to content store, unless the pre-push already went through
+	  // the admission
+	  if (!m_prepush)
+	    StoreRedirected (data);
 
 	  // Save the information in our map and wait for further instructions
 	  if (m_edge)
 	    {
 	      if (m_passthrough)
 		{
-		  for (it = dataRedirect.begin(); it != dataRedirect.end(); it++)
-		    {
-		      Ptr<Face> touse = (*it);
-		      // The Data we have received, doesn't have a PIT entry, so we create it
-		      // Create a Nonce
-		      UniformVariable m_rand = UniformVariable(0, std::numeric_limits<uint32_t>::max ());
-
-		      // Obtain the name from the Data packet
-		      Ptr<ndn::Name> incoming_name = Create<ndn::Name> (data->GetName());
-
-		      // Create the Interest packet using the information we have
-		      Ptr<Interest> interest = Create<Interest> ();
-		      interest->SetNonce               (m_rand.GetValue ());
-		      interest->SetName                (incoming_name);
-		      interest->SetInterestLifetime    (Years (1));
-
-		      // Create a newly created PIT Entry
-		      pitEntry = m_pit->Create (interest);
-		      if (pitEntry != 0)
-			{
-			  DidCreatePitEntry (touse, interest, pitEntry);
-			}
-
-		      pitEntry->AddSeenNonce (interest->GetNonce ());
-
-		      pitEntry->AddIncoming(touse);
-
-		      pitEntry->UpdateLifetime(interest->GetInterestLifetime ());
-
-		      // Do data plane performance measurements
-		      WillSatisfyPendingInterest (inFace, pitEntry);
-
-		      // Actually satisfy pending interest
-		      SatisfyPendingInterest (inFace, data, pitEntry);
-		    }
+		  m_counters.passthrough++;
+		  m_passthroughData (data, inFace);
+		  PushData (inFace, data);
 		}
-	      else
+	      else if (m_redirects.Matches (data->GetName (), RedirectTable::DATA))
 		{
-		  for (it = dataRedirect.begin(); it != dataRedirect.end(); it++)
-		    {
-		      superData curr;
-		      curr.inface = inFace;
-		      curr.outface = (*it);
-		      curr.data = data;
-		      buffer[now] = curr;
-		    }
+		  // A single entry serves all the redirect faces, the face is
+		  // chosen when the buffer is flushed
+		  BufferData (inFace, data);
 		}
 	      return;
 	    }
 	  else
 	    {
-	      for (it = dataRedirect.begin(); it != dataRedirect.end(); it++)
-		{
-		  Ptr<Face> touse = (*it);
-		  // The Data we have received, doesn't have a PIT entry, so we create it
-		  // Create a Nonce
-		  UniformVariable m_rand = UniformVariable(0, std::numeric_limits<uint32_t>::max ());
-
-		  // Obtain the name from the Data packet
-		  Ptr<ndn::Name> incoming_name = Create<ndn::Name> (data->GetName());
-
-		  // Create the Interest packet using the information we have
-		  Ptr<Interest> interest = Create<Interest> ();
-		  interest->SetNonce               (m_rand.GetValue ());
-		  interest->SetName                (incoming_name);
-		  interest->SetInterestLifetime    (Years (1));
-
-		  // Create a newly created PIT Entry
-		  pitEntry = m_pit->Create (interest);
-		  if (pitEntry != 0)
-		    {
-		      DidCreatePitEntry (touse, interest, pitEntry);
-		    }
-
-		  pitEntry->AddSeenNonce (interest->GetNonce ());
-
-		  pitEntry->AddIncoming(touse);
-
-		  pitEntry->UpdateLifetime(interest->GetInterestLifetime ());
-
-		  // Do data plane performance measurements
-		  WillSatisfyPendingInterest (inFace, pitEntry);
-
-		  // Actually satisfy pending interest
-		  SatisfyPendingInterest (inFace, data, pitEntry);
-		}
-
+	      PushData (inFace, data);
 	      return;
 	    }
 	}
@@ -248,11 +343,8 @@ SmartFloodingInf::OnData (Ptr<Face> inFace, Ptr<Data> data)
       DidReceiveSolicitedData (inFace, data, cached);
     }
 
-  superData curr;
-  curr.data = data;
-  curr.outface = 0;
-  curr.inface = inFace;
-  buffer[now] = curr;
+  if (HasRedirectRole ())
+    BufferData (inFace, data);
 
   while (pitEntry != 0)
     {
@@ -267,6 +359,159 @@ SmartFloodingInf::OnData (Ptr<Face> inFace, Ptr<Data> data)
     }
 }
 
+void
+SmartFloodingInf::PushData (Ptr<Face> inFace, Ptr<const Data> data)
+{
+  std::vector<Ptr<Face> > faces;
+  faces.swap (m_redirectScratch);
+  faces.clear ();
+
+  m_redirects.Lookup (data->GetName (), RedirectTable::DATA, faces);
+
+  // Sector redirection also gets a copy, as it would have when satisfying
+  // a PIT entry for this Data. The lookup skips faces already found
+  if (m_redirect)
+    m_redirects.Lookup (data->GetName (), RedirectTable::SECTOR, faces);
+
+  BOOST_FOREACH (Ptr<Face> touse, faces)
+  {
+    SendRedirected (inFace, touse, data, 0);
+  }
+
+  faces.swap (m_redirectScratch);
+}
+
+void
+SmartFloodingInf::SendRedirected (Ptr<Face> inFace, Ptr<Face> outFace, Ptr<const Data> data, Ptr<pit::Entry> pitEntry)
+{
+  bool ok = outFace->SendData (data);
+
+  DidSendOutData (inFace, outFace, data, pitEntry);
+  NS_LOG_DEBUG ("Redirect " << data->GetName () << " to " << *outFace);
+
+  uint32_t id = outFace->GetId ();
+  if (id >= m_counters.redirectedPerFace.size ())
+    m_counters.redirectedPerFace.resize (id + 1, 0);
+
+  m_counters.redirectedPerFace[id]++;
+  m_counters.redirected++;
+  m_redirectedData (data, outFace);
+
+  if (!ok)
+    {
+      m_dropData (data, outFace);
+      NS_LOG_DEBUG ("Cannot redirect data to " << *outFace);
+
+      m_counters.redirectDrops++;
+      m_redirectDrop (data, outFace);
+    }
+}
+
+void
+SmartFloodingInf::BufferData (Ptr<Face> inFace, Ptr<Data> data)
+{
+  superData curr;
+  curr.data = data;
+  curr.outface = 0;
+  curr.inface = inFace;
+  buffer.Push (curr);
+
+  m_counters.buffered++;
+  m_bufferedData (data, inFace);
+  m_bufferOccupancy (buffer.GetSize (), buffer.GetBytes ());
+}
+
+void
+SmartFloodingInf::AdmitPrepushed (Ptr<Face> inFace, Ptr<Data> data)
+{
+  if (!StoreRedirected (data))
+    return;
+
+  superData curr;
+  curr.data = data;
+  curr.outface = 0;
+  curr.inface = inFace;
+  m_prepushed.Push (curr);
+
+  m_counters.prepushed++;
+  m_prepushedData (data, inFace);
+}
+
+bool
+SmartFloodingInf::StoreRedirected (Ptr<const Data> data)
+{
+  if (m_redirectStore == 0)
+    return m_contentStore->Add (data);
+
+  if (!AdmitRedirected (data))
+    {
+      NS_LOG_DEBUG ("Not admitting " << data->GetName ());
+      m_counters.redirectStore.rejected++;
+      return false;
+    }
+
+  bool added = m_redirectStore->Add (data);
+  if (added)
+    m_counters.redirectStore.admitted++;
+
+  return added;
+}
+
+bool
+SmartFloodingInf::AdmitRedirected (Ptr<const Data> data)
+{
+  const Name &name = data->GetName ();
+
+  if (m_redirectAdmitWindow == 0 || name.size () == 0)
+    return true;
+
+  // Sequence numbers carry a zero marker byte, toSeqNum throws on anything
+  // else, which the window has nothing to say about
+  const name::Component &last = name.get (-1);
+  if (last.empty () || last[0] != 0)
+    return true;
+
+  uint64_t seq = last.toSeqNum ();
+  std::pair<std::map<Name, uint64_t>::iterator, bool> newest =
+      m_newestRedirected.insert (std::make_pair (name.getPrefix (name.size () - 1), seq));
+
+  if (seq > newest.first->second)
+    newest.first->second = seq;
+
+  // Older Data was most likely already received by the mobile
+  return seq + m_redirectAdmitWindow > newest.first->second;
+}
+
+void
+SmartFloodingInf::CountCacheHit (Ptr<const Interest> interest, Ptr<const Data> data)
+{
+  m_counters.mainStore.hits++;
+  CountPartitionMiss ();
+}
+
+void
+SmartFloodingInf::CountCacheMiss (Ptr<const Interest> interest)
+{
+  m_counters.mainStore.misses++;
+  CountPartitionMiss ();
+}
+
+void
+SmartFloodingInf::CountPartitionMiss ()
+{
+  if (!m_partitionMissed)
+    return;
+
+  m_counters.redirectStore.misses++;
+  m_partitionMissed = false;
+}
+
+const RedirectCounters &
+SmartFloodingInf::GetCounters () const
+{
+  return m_counters;
+}
+
 void
 SmartFloodingInf::WillEraseTimedOutPendingInterest (Ptr<pit::Entry> pitEntry)
 {
@@ -301,7 +546,11 @@ SmartFloodingInf::WillSatisfyPendingInterest (Ptr<Face> inFace, Ptr<pit::Entry>
       // If we have sent interest for this data via this face, then update stats.
       if (out != pitEntry->GetOutgoing ().end ())
 	{
-	  pitEntry->GetFibEntry ()->UpdateFaceRtt (inFace, Simulator::Now () - out->m_sendTime);
+	  Time rtt = Simulator::Now () - out->m_sendTime;
+	  pitEntry->GetFibEntry ()->UpdateFaceRtt (inFace, rtt);
+
+	  // Keep our own estimate to size the replay window
+	  UpdateRtt (GetStreamPrefix (pitEntry->GetPrefix ()), rtt);
 	}
     }
 
@@ -314,83 +563,467 @@ SmartFloodingInf::flushBuffer (Ptr<Face> face) {
   // Get our current time
   Time now = Simulator::Now ();
 
-  std::map<Time, superData>::iterator ij;
+  // Drop anything that has grown too old to be useful
+  buffer.Expire ();
+  m_bufferOccupancy (buffer.GetSize (), buffer.GetBytes ());
+
+  NS_LOG_INFO ("Historical buffer of " << buffer.GetSize () << " at " << now);
+
+  // A new flush through the same face replaces the one in progress
+  drain_map::iterator old = m_drains.find (face);
+  if (old != m_drains.end ())
+    {
+      Simulator::Cancel (old->second.event);
+      FinishFlush (old);
+    }
+
+  FlushDrain &drain = m_drains[face];
+  drain.next = 0;
+  drain.stats.start = now;
+
+  // Oldest and newest Data buffered for each prefix, the buffer is in
+  // arrival order
+  typedef std::map<Name, std::pair<Time, Time> > range_map;
+  range_map from;
+  std::vector<range_map::iterator> prefixes;
+  prefixes.reserve (buffer.GetSize ());
+
+  for (RedirectBuffer::iterator ij = buffer.begin (); ij != buffer.end (); ++ij)
+    {
+      std::pair<range_map::iterator, bool> range =
+	  from.insert (std::make_pair (GetStreamPrefix (ij->item.data->GetName ()),
+				       std::make_pair (ij->arrival, ij->arrival)));
+      range.first->second.second = ij->arrival;
+      prefixes.push_back (range.first);
+    }
+
+  for (range_map::iterator it = from.begin (); it != from.end (); ++it)
+    {
+      it->second.first = GetReplayStart (it->first, it->second.first, it->second.second);
+      NS_LOG_INFO ("Flushing " << it->first << " from " << it->second.first);
+    }
+
+  // The buffer keeps a single entry per name, so the drain is bounded by
+  // the number of distinct names
+  uint32_t i = 0;
+  for (RedirectBuffer::iterator ij = buffer.begin (); ij != buffer.end (); ++ij, ++i)
+    {
+      if (ij->arrival >= prefixes[i]->second.first)
+	drain.queue.push_back (ij->item.data);
+    }
+
+  drain.stats.backlog = drain.queue.size ();
 
-  std::string lastname;
+  m_counters.flushes++;
+  m_flushStart (face, drain.stats.backlog);
 
-  int total = 0;
+  DrainFlush (face);
+}
 
-  std::cout << "Historical buffer of " << buffer.size () << " at " << now << std::endl;
-  std::cout << "Flushing from " << m_start +m_rtx << std::endl;
+FlushStats
+SmartFloodingInf::GetLastFlushStats () const
+{
+  return m_lastFlush;
+}
 
-  for (ij = buffer.lower_bound(m_start + m_rtx) ; ij != buffer.end(); ++ij)
+void
+SmartFloodingInf::DrainFlush (Ptr<Face> face)
+{
+  drain_map::iterator it = m_drains.find (face);
+  if (it == m_drains.end ())
+    return;
+
+  FlushDrain &drain = it->second;
+  uint32_t burst = 0;
+
+  while (drain.next < drain.queue.size () && (m_flushBurst == 0 || burst < m_flushBurst))
     {
+      Ptr<const Data> data = drain.queue[drain.next++];
 
-      Ptr<pit::Entry> pitEntry = m_pit->Lookup (*(*ij).second.data);
+      Ptr<pit::Entry> pitEntry = m_pit->Lookup (*data);
       if (pitEntry != 0)
 	{
-	  std::cout << "I have a PIT entry for this, why?" << std::endl;
+	  // The consumer is asking for buffered Data again, so it has
+	  // caught up and the rest will come back the usual way
+	  if (m_flushStopOnCatchUp && IsPendingOn (pitEntry, face))
+	    {
+	      NS_LOG_DEBUG ("Consumer caught up at " << data->GetName ());
+	      drain.stats.stoppedEarly = true;
+	      drain.next = drain.queue.size ();
+	      break;
+	    }
+
+	  // The Interest is pending, the Data will come back the usual way
+	  NS_LOG_DEBUG ("PIT entry present for " << data->GetName ());
+	  drain.stats.skipped++;
+	  continue;
+	}
+
+      RedirectBuffer::iterator entry = buffer.Find (data->GetName ());
+      if (entry != buffer.end () && !buffer.MarkSent (entry, face))
+	{
+	  NS_LOG_DEBUG ("Already sent " << data->GetName () << " through face " << face->GetId ());
+	  drain.stats.skipped++;
+	  continue;
+	}
+
+      burst++;
+      if (face->SendData (data))
+	{
+	  NS_LOG_DEBUG ("Sent out " << data->GetName () << " through face " << face->GetId ());
+	  drain.stats.sent++;
+	  m_counters.flushed++;
 	}
       else
 	{
-	  std::cout << "No PIT, must create" << std::endl;
-	  // Create a Nonce
-	  UniformVariable m_rand = UniformVariable(0, std::numeric_limits<uint32_t>::max ());
-
-	  // Obtain the name from the Data packet
-	  Ptr<ndn::Name> incoming_name = Create<ndn::Name> ((*ij).second.data->GetName());
-
-//	  // Create the Interest packet using the information we have
-//	  Ptr<Interest> interest = Create<Interest> ();
-//	  interest->SetNonce               (m_rand.GetValue ());
-//	  interest->SetName                (incoming_name);
-//	  interest->SetInterestLifetime    (Years (1));
-//
-//	  Create a newly created PIT Entry
-//	  Ptr<pit::Entry> pitEntry = m_pit->Create (interest);
-//	  if (pitEntry != 0)
-//	    {
-//	      DidCreatePitEntry ((*ij).second.inface, interest, pitEntry);
-//	    }
-	  //
-	  //      pitEntry->AddSeenNonce (interest->GetNonce ());
-	  lastname = incoming_name->toUri();
-
-//	  Ptr<Face> touse = (*ij).second.outface;
-//	  if (touse == 0)
-//	    {
-//	      // Iterator
-//	      std::set<Ptr<Face> >::iterator it;
-//	      for (it = dataRedirect.begin(); it != dataRedirect.end(); it++)
-//		{
-//		  //pitEntry->AddIncoming ((*it));
-//		  (*it)->SendData((*ij).second.data);
-//		  std::cout << "Sent out " << lastname << " through face " << (*it) << std::endl;
-//		}
-//	    }
-//	  else
-//	    {
-	      //pitEntry->AddIncoming (touse);
-	      face->SendData((*ij).second.data);
-	      std::cout << "Information present Sent out " << lastname << " through face " << face->GetId() << std::endl;
-//	    }
-
-//	  pitEntry->UpdateLifetime(interest->GetInterestLifetime ());
-//
-//	  WillSatisfyPendingInterest ((*ij).second.inface, pitEntry);
-//	  SatisfyPendingInterest((*ij).second.inface, (*ij).second.data, pitEntry);
-
-	  total++;
+	  m_dropData (data, face);
+	  drain.stats.dropped++;
+
+	  m_counters.redirectDrops++;
+	  m_redirectDrop (data, face);
 	}
     }
 
-  std::cout << "Transmitted " << total << std::endl;
-  std::cout << "Last name transmitted " << lastname << std::endl;
+  if (drain.next < drain.queue.size ())
+    drain.event = Simulator::Schedule (m_flushInterval, &SmartFloodingInf::DrainFlush, this, face);
+  else
+    FinishFlush (it);
+}
+
+void
+SmartFloodingInf::FinishFlush (drain_map::iterator drain)
+{
+  m_lastFlush = drain->second.stats;
+  m_lastFlush.duration = Simulator::Now () - m_lastFlush.start;
+
+  NS_LOG_INFO ("Flush through face " << drain->first->GetId () << " sent " << m_lastFlush.sent
+	       << ", dropped " << m_lastFlush.dropped << ", skipped " << m_lastFlush.skipped
+	       << " of " << m_lastFlush.backlog << " in " << m_lastFlush.duration);
+
+  m_flushEnd (drain->first, m_lastFlush);
+
+  m_drains.erase (drain);
+}
+
+bool
+SmartFloodingInf::IsPendingOn (Ptr<pit::Entry> pitEntry, Ptr<Face> face)
+{
+  BOOST_FOREACH (const pit::IncomingFace &incoming, pitEntry->GetIncoming ())
+  {
+    if (incoming.m_face == face)
+      return true;
+  }
+
+  return false;
 }
 
 uint32_t
 SmartFloodingInf::bufferSize () {
-  return buffer.size ();
+  return buffer.GetSize ();
+}
+
+uint64_t
+SmartFloodingInf::bufferBytes () {
+  return buffer.GetBytes ();
+}
+
+void
+SmartFloodingInf::SetBufferCapacity (uint32_t capacity)
+{
+  buffer.SetCapacity (capacity);
+  m_prepushed.SetCapacity (capacity);
+}
+
+uint32_t
+SmartFloodingInf::GetBufferCapacity () const
+{
+  return buffer.GetCapacity ();
+}
+
+void
+SmartFloodingInf::SetBufferMaxAge (Time maxAge)
+{
+  buffer.SetMaxAge (maxAge);
+  m_prepushed.SetMaxAge (maxAge);
+}
+
+Time
+SmartFloodingInf::GetBufferMaxAge () const
+{
+  return buffer.GetMaxAge ();
+}
+
+void
+SmartFloodingInf::SetRedirectStoreSize (uint32_t size)
+{
+  m_redirectStoreSize = size;
+
+  if (size == 0)
+    {
+      m_redirectStore = 0;
+      return;
+    }
+
+  if (m_redirectStore == 0)
+    {
+      ObjectFactory factory;
+      factory.SetTypeId ("ns3::ndn::cs::Lru");
+      factory.Set ("MaxSize", UintegerValue (size));
+      m_redirectStore = factory.Create<ContentStore> ();
+    }
+  else
+    m_redirectStore->SetAttribute ("MaxSize", UintegerValue (size));
+}
+
+uint32_t
+SmartFloodingInf::GetRedirectStoreSize () const
+{
+  return m_redirectStoreSize;
+}
+
+void
+SmartFloodingInf::AddRedirectRule (const Name &prefix, uint32_t consumer, Ptr<Face> face, Time lease)
+{
+  Time expiry = GetLeaseExpiry (lease);
+
+  m_redirects.Add (prefix, consumer, face, RedirectTable::SECTOR, expiry);
+  m_redirect = true;
+  ScheduleLeaseExpiry (expiry);
+}
+
+void
+SmartFloodingInf::AddDataRedirectRule (const Name &prefix, uint32_t consumer, Ptr<Face> face, Time lease)
+{
+  Time expiry = GetLeaseExpiry (lease);
+
+  m_redirects.Add (prefix, consumer, face, RedirectTable::DATA, expiry);
+  m_data_redirect = true;
+  ScheduleLeaseExpiry (expiry);
+}
+
+void
+SmartFloodingInf::RemoveRedirectRule (const Name &prefix, uint32_t consumer, Ptr<Face> face)
+{
+  m_redirects.Remove (prefix, consumer, face, RedirectTable::SECTOR);
+  UpdateRedirectFlags ();
+}
+
+void
+SmartFloodingInf::RemoveDataRedirectRule (const Name &prefix, uint32_t consumer, Ptr<Face> face)
+{
+  m_redirects.Remove (prefix, consumer, face, RedirectTable::DATA);
+  UpdateRedirectFlags ();
+}
+
+void
+SmartFloodingInf::RemoveRedirectRules (const Name &prefix, uint32_t consumer)
+{
+  m_redirects.Remove (prefix, consumer, RedirectTable::SECTOR);
+  UpdateRedirectFlags ();
+}
+
+void
+SmartFloodingInf::RemoveDataRedirectRules (const Name &prefix, uint32_t consumer)
+{
+  m_redirects.Remove (prefix, consumer, RedirectTable::DATA);
+  UpdateRedirectFlags ();
+}
+
+void
+SmartFloodingInf::RemoveConsumer (uint32_t consumer)
+{
+  m_redirects.RemoveConsumer (consumer);
+  UpdateRedirectFlags ();
+}
+
+void
+SmartFloodingInf::AddRedirectFace (Ptr<Face> face, Time lease)
+{
+  AddRedirectRule (Name ("/"), 0, face, lease);
+}
+
+void
+SmartFloodingInf::AddDataRedirectFace (Ptr<Face> face, Time lease)
+{
+  AddDataRedirectRule (Name ("/"), 0, face, lease);
+}
+
+void
+SmartFloodingInf::RemoveRedirectFace (Ptr<Face> face)
+{
+  RemoveRedirectRule (Name ("/"), 0, face);
+}
+
+void
+SmartFloodingInf::RemoveDataRedirectFace (Ptr<Face> face)
+{
+  RemoveDataRedirectRule (Name ("/"), 0, face);
+}
+
+void
+SmartFloodingInf::ClearRedirection ()
+{
+  m_redirect = false;
+  m_redirects.Clear (RedirectTable::SECTOR);
+}
+
+void
+SmartFloodingInf::ClearDataRedirection ()
+{
+  m_data_redirect = false;
+  m_redirects.Clear (RedirectTable::DATA);
+}
+
+const RedirectTable &
+SmartFloodingInf::GetRedirectTable () const
+{
+  return m_redirects;
+}
+
+Time
+SmartFloodingInf::GetLeaseExpiry (Time lease) const
+{
+  if (lease.IsZero ())
+    lease = m_lease;
+
+  // Without a lease the rule stays until it is removed
+  if (lease.IsZero ())
+    return Time::Max ();
+
+  return Simulator::Now () + lease;
+}
+
+void
+SmartFloodingInf::ScheduleLeaseExpiry (Time expiry)
+{
+  if (expiry == Time::Max ())
+    return;
+
+  // A single event is kept for the earliest lease
+  if (m_leaseEvent.IsRunning ())
+    {
+      if (m_leaseCheck <= expiry)
+	return;
+
+      Simulator::Cancel (m_leaseEvent);
+    }
+
+  m_leaseCheck = expiry;
+  m_leaseEvent = Simulator::Schedule (expiry - Simulator::Now (), &SmartFloodingInf::ExpireLeases, this);
+}
+
+void
+SmartFloodingInf::ExpireLeases ()
+{
+  std::vector<RedirectTable::Rule> expired;
+  Time next = m_redirects.Expire (Simulator::Now (), expired);
+
+  BOOST_FOREACH (const RedirectTable::Rule &rule, expired)
+  {
+    NS_LOG_INFO ("Redirect lease of " << rule.prefix << " for consumer " << rule.consumer
+		 << " through face " << rule.face->GetId () << " ran out");
+
+    m_counters.leaseExpiries++;
+    m_redirectExpired (rule.face, rule.kind == RedirectTable::DATA);
+  }
+
+  UpdateRedirectFlags ();
+  ScheduleLeaseExpiry (next);
+}
+
+void
+SmartFloodingInf::UpdateRedirectFlags ()
+{
+  if (m_redirects.IsEmpty (RedirectTable::SECTOR))
+    m_redirect = false;
+
+  if (m_redirects.IsEmpty (RedirectTable::DATA))
+    m_data_redirect = false;
+}
+
+Time
+SmartFloodingInf::GetReplayStart (const Name &prefix) const
+{
+  bool found = false;
+  Time oldest;
+  Time newest;
+
+  for (RedirectBuffer::const_iterator ij = buffer.begin (); ij != buffer.end (); ++ij)
+    {
+      if (GetStreamPrefix (ij->item.data->GetName ()) != prefix)
+	continue;
+
+      if (!found)
+	oldest = ij->arrival;
+      newest = ij->arrival;
+      found = true;
+    }
+
+  if (!found)
+    return GetReplayStart (prefix, Time::Max (), Time::Max ());
+
+  return GetReplayStart (prefix, oldest, newest);
+}
+
+Time
+SmartFloodingInf::GetReplayStart (const Name &prefix, Time oldest, Time newest) const
+{
+  std::map<Name, RttEstimate>::const_iterator rtt = m_rtt.find (prefix);
+
+  if (!m_adaptiveReplay || rtt == m_rtt.end ())
+    return m_start + m_rtx;
+
+  // Data arriving within a retransmission timeout of the handoff is
+  // re-requested by the mobile itself
+  Time from = m_start + Seconds (rtt->second.srtt.GetSeconds () + 4 * rtt->second.rttvar.GetSeconds ());
+
+  // However late the flush runs, it replays at least the newest Data held
+  if (from > newest)
+    from = newest;
+  if (from < oldest)
+    from = oldest;
+
+  return from;
+}
+
+Time
+SmartFloodingInf::GetSmoothedRtt (const Name &prefix) const
+{
+  std::map<Name, RttEstimate>::const_iterator rtt = m_rtt.find (prefix);
+
+  if (rtt == m_rtt.end ())
+    return Seconds (0);
+
+  return rtt->second.srtt;
+}
+
+void
+SmartFloodingInf::UpdateRtt (const Name &prefix, Time rtt)
+{
+  RttEstimate &estimate = m_rtt[prefix];
+
+  // Same smoothing as RFC 6298
+  double sample = rtt.GetSeconds ();
+
+  if (estimate.samples == 0)
+    {
+      estimate.srtt = rtt;
+      estimate.rttvar = Seconds (sample / 2);
+    }
+  else
+    {
+      double srtt = estimate.srtt.GetSeconds ();
+      estimate.rttvar = Seconds (0.75 * estimate.rttvar.GetSeconds () + 0.25 * std::fabs (srtt - sample));
+      estimate.srtt = Seconds (0.875 * srtt + 0.125 * sample);
+    }
+
+  estimate.samples++;
+}
+
+bool
+SmartFloodingInf::HasRedirectRole () const
+{
+  return m_redirect || m_data_redirect;
 }
 
 } /* namespace fw */
@@ -34,8 +34,11 @@
 #include <ns3-dev/ns3/boolean.h>
 #include <ns3-dev/ns3/log.h>
 #include <ns3-dev/ns3/nstime.h>
+#include <ns3-dev/ns3/object-factory.h>
 #include <ns3-dev/ns3/random-variable.h>
 #include <ns3-dev/ns3/simulator.h>
+#include <ns3-dev/ns3/traced-callback.h>
+#include <ns3-dev/ns3/uinteger.h>
 
 #include <boost/ref.hpp>
 #include <boost/foreach.hpp>
@@ -43,16 +46,76 @@
 #include <boost/lambda/bind.hpp>
 namespace ll = boost::lambda;
 
+#include "face-mask.h"
+#include "redirect-buffer.h"
+#include "redirect-table.h"
+
 namespace ns3 {
   namespace ndn {
     namespace fw {
 
-      typedef struct {
-	Ptr<Face> inface;
-	Ptr<Face> outface;
-	Ptr<Data> data;
-      } superData;
+      // Counters describing a single buffer flush through a Face
+      struct FlushStats {
+	FlushStats ()
+	: backlog (0), sent (0), dropped (0), skipped (0), stoppedEarly (false)
+	{
+	}
+
+	uint32_t backlog;     // Data selected for the flush
+	uint32_t sent;        // Data the Face accepted
+	uint32_t dropped;     // Data the Face refused
+	uint32_t skipped;     // Data pending in the PIT or already sent
+	bool stoppedEarly;    // Consumer caught up before the drain ended
+	Time start;
+	Time duration;
+      };
+
+      // Lookups and admissions of one Content Store partition
+      struct PartitionCounters {
+	PartitionCounters ()
+	: hits (0), misses (0), admitted (0), rejected (0)
+	{
+	}
+
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t admitted;
+	uint64_t rejected;      // Data the admission policy turned away
+      };
+
+      // Cumulative counters of the redirection work done by a node
+      struct RedirectCounters {
+	RedirectCounters ()
+	: buffered (0), redirected (0), passthrough (0), flushes (0), flushed (0), redirectDrops (0)
+	, prepushed (0), prepushUsed (0), leaseExpiries (0)
+	{
+	}
 
+	uint64_t buffered;      // Data added to the buffer
+	uint64_t redirected;    // Data sent through redirect faces
+	uint64_t passthrough;   // Unsolicited Data pushed through by an edge
+	uint64_t flushes;       // Flushes started
+	uint64_t flushed;       // Data sent by flushes
+	uint64_t redirectDrops; // Redirected or flushed Data refused by a face
+	uint64_t prepushed;     // Unsolicited Data admitted ahead of a handoff
+	uint64_t prepushUsed;   // Pre-pushed Data later served from the cache
+	uint64_t leaseExpiries; // Redirect rules removed because their lease ran out
+	// Data sent through redirect faces, indexed by Face Id
+	std::vector<uint64_t> redirectedPerFace;
+	PartitionCounters mainStore;
+	PartitionCounters redirectStore;
+      };
+
+      /**
+       * \brief SmartFlooding with Interest and Data redirection for handoffs
+       *
+       * Besides the usual ForwardingStrategy traces, the redirection work is
+       * exposed through BufferedData, RedirectedData, PassthroughData,
+       * RedirectDrop, FlushStart, FlushEnd, BufferOccupancy, PrepushedData,
+       * PrepushUsed and RedirectExpired, reachable
+       * through the Config path of the strategy, for instance
+       * /NodeList/0/$ns3::ndn::ForwardingStrategy/$ns3::ndn::fw::SmartFloodingInf/FlushEnd
+       */
       class SmartFloodingInf : public SmartFlooding {
       public:
 	static TypeId
@@ -66,6 +129,10 @@ namespace ns3 {
 				Ptr<const Data> data,
 				Ptr<pit::Entry> pitEntry);
 
+	virtual void
+	OnInterest (Ptr<Face> face,
+		    Ptr<Interest> interest);
+
 	virtual void
 	OnData (Ptr<Face> face,
 		Ptr<Data> data);
@@ -76,24 +143,250 @@ namespace ns3 {
 	virtual void
 	WillSatisfyPendingInterest (Ptr<Face> inFace, Ptr<pit::Entry> pitEntry);
 
+	// Drain the buffered Data newer than the GetReplayStart () of its prefix
+	// through the face, FlushBurst Data every FlushInterval (all at once if
+	// FlushBurst is 0)
 	void
 	flushBuffer (Ptr<Face> face);
 
+	// Forward unsolicited Data to the redirect faces directly, without
+	// creating Interests or PIT entries for it
+	void
+	PushData (Ptr<Face> inFace, Ptr<const Data> data);
+
+	FlushStats
+	GetLastFlushStats () const;
+
+	const RedirectCounters &
+	GetCounters () const;
+
+	// Oldest Data under prefix a flush replays. With AdaptiveReplay this is
+	// derived from the RTT measured for the prefix and kept within the
+	// buffered Data, otherwise it is m_start + m_rtx. The prefix is the
+	// Data name without its sequence number
+	Time
+	GetReplayStart (const Name &prefix) const;
+
+	Time
+	GetSmoothedRtt (const Name &prefix) const;
+
 	uint32_t
 	bufferSize();
 
+	uint64_t
+	bufferBytes();
+
+	void
+	SetBufferCapacity (uint32_t capacity);
+
+	uint32_t
+	GetBufferCapacity () const;
+
+	void
+	SetBufferMaxAge (Time maxAge);
+
+	Time
+	GetBufferMaxAge () const;
+
+	// Size of the Content Store partition holding redirected Data, 0
+	// keeps redirected Data in the main Content Store
+	void
+	SetRedirectStoreSize (uint32_t size);
+
+	uint32_t
+	GetRedirectStoreSize () const;
+
+	// Redirect Data under prefix to the face on behalf of a consumer and
+	// turn redirection on. Rules can be leased: a rule is removed once its
+	// lease runs out unless it is added again, and redirection is turned
+	// off when no rule is left. A zero lease uses RedirectLease, which
+	// keeps rules until they are removed by default
+	void
+	AddRedirectRule (const Name &prefix, uint32_t consumer, Ptr<Face> face, Time lease = Seconds (0));
+
+	void
+	AddDataRedirectRule (const Name &prefix, uint32_t consumer, Ptr<Face> face, Time lease = Seconds (0));
+
+	void
+	RemoveRedirectRule (const Name &prefix, uint32_t consumer, Ptr<Face> face);
+
+	void
+	RemoveDataRedirectRule (const Name &prefix, uint32_t consumer, Ptr<Face> face);
+
+	// Drop the rules of a consumer for a prefix on all the faces
+	void
+	RemoveRedirectRules (const Name &prefix, uint32_t consumer);
+
+	void
+	RemoveDataRedirectRules (const Name &prefix, uint32_t consumer);
+
+	// Drop all the rules of a consumer, for instance once it has associated
+	void
+	RemoveConsumer (uint32_t consumer);
+
+	// Rules for all the Data, with consumer 0
+	void
+	AddRedirectFace (Ptr<Face> face, Time lease = Seconds (0));
+
+	void
+	AddDataRedirectFace (Ptr<Face> face, Time lease = Seconds (0));
+
+	void
+	RemoveRedirectFace (Ptr<Face> face);
+
+	void
+	RemoveDataRedirectFace (Ptr<Face> face);
+
+	// Turn off redirection and forget all the rules
+	void
+	ClearRedirection ();
+
+	void
+	ClearDataRedirection ();
+
+	const RedirectTable &
+	GetRedirectTable () const;
+
 	Time m_start;
 	Time m_rtx;
 	bool m_redirect;
 	bool m_data_redirect;
 	bool m_edge;
 	bool m_passthrough;
+	// Accept unsolicited Data into the Content Store for a mobile that is
+	// expected to associate soon
+	bool m_prepush;
 
-	std::set<Ptr<Face> > redirectFaces;
-	std::set<Ptr<Face> > dataRedirect;
-	std::map<Time, superData> buffer;
+	RedirectBuffer buffer;
+
+      protected:
+	virtual void
+	NotifyNewAggregate ();
 
       private:
+	void
+	SendRedirected (Ptr<Face> inFace, Ptr<Face> outFace, Ptr<const Data> data, Ptr<pit::Entry> pitEntry);
+
+	void
+	BufferData (Ptr<Face> inFace, Ptr<Data> data);
+
+	void
+	AdmitPrepushed (Ptr<Face> inFace, Ptr<Data> data);
+
+	// Cache redirected Data, in its own partition if there is one. Returns
+	// true if the Data was added
+	bool
+	StoreRedirected (Ptr<const Data> data);
+
+	// Admission policy of the redirect partition: only sequences within
+	// RedirectAdmitWindow of the newest one seen for the prefix
+	bool
+	AdmitRedirected (Ptr<const Data> data);
+
+	void
+	CountCacheHit (Ptr<const Interest> interest, Ptr<const Data> data);
+
+	void
+	CountCacheMiss (Ptr<const Interest> interest);
+
+	void
+	CountPartitionMiss ();
+
+	void
+	UpdateRtt (const Name &prefix, Time rtt);
+
+	// Replay start of prefix given its oldest and newest buffered Data
+	Time
+	GetReplayStart (const Name &prefix, Time oldest, Time newest) const;
+
+	Time
+	GetLeaseExpiry (Time lease) const;
+
+	void
+	ScheduleLeaseExpiry (Time expiry);
+
+	// Turn redirection off when no rule of its kind is left
+	void
+	UpdateRedirectFlags ();
+
+	// Drop the faces whose lease ran out and schedule the next check
+	void
+	ExpireLeases ();
+
+	// Only nodes taking part in a redirection need to keep Data around
+	bool
+	HasRedirectRole () const;
+
+	struct FlushDrain {
+	  std::vector<Ptr<const Data> > queue;
+	  uint32_t next;
+	  EventId event;
+	  FlushStats stats;
+	};
+
+	typedef std::map<Ptr<Face>, FlushDrain> drain_map;
+
+	void
+	DrainFlush (Ptr<Face> face);
+
+	void
+	FinishFlush (drain_map::iterator drain);
+
+	// True when the Face is waiting on the PIT entry
+	bool
+	IsPendingOn (Ptr<pit::Entry> pitEntry, Ptr<Face> face);
+
+	RedirectTable m_redirects;
+	// Reused by the lookups in the Data path
+	std::vector<Ptr<Face> > m_redirectScratch;
+
+	uint32_t m_flushBurst;
+	Time m_flushInterval;
+	bool m_flushStopOnCatchUp;
+	drain_map m_drains;
+	FlushStats m_lastFlush;
+
+	struct RttEstimate {
+	  RttEstimate () : samples (0) {}
+
+	  uint32_t samples;
+	  Time srtt;
+	  Time rttvar;
+	};
+
+	bool m_adaptiveReplay;
+	// Kept per prefix, the nodes see the traffic of several consumers
+	std::map<Name, RttEstimate> m_rtt;
+
+	Ptr<ContentStore> m_redirectStore;
+	uint32_t m_redirectStoreSize;
+	uint32_t m_redirectAdmitWindow;
+	std::map<Name, uint64_t> m_newestRedirected;
+	bool m_cacheTraced;
+	// The Interest being forwarded was not in the redirect partition
+	bool m_partitionMissed;
+
+	Time m_lease;
+	EventId m_leaseEvent;
+	Time m_leaseCheck;
+
+	// Names of the pre-pushed Data not yet served, bounded like the buffer
+	RedirectBuffer m_prepushed;
+
+	RedirectCounters m_counters;
+
+	TracedCallback<Ptr<const Data>, Ptr<const Face> > m_bufferedData;
+	TracedCallback<Ptr<const Data>, Ptr<const Face> > m_redirectedData;
+	TracedCallback<Ptr<const Data>, Ptr<const Face> > m_passthroughData;
+	TracedCallback<Ptr<const Data>, Ptr<const Face> > m_redirectDrop;
+	TracedCallback<Ptr<const Face>, uint32_t> m_flushStart;
+	TracedCallback<Ptr<const Face>, const FlushStats &> m_flushEnd;
+	TracedCallback<uint32_t, uint64_t> m_bufferOccupancy;
+	TracedCallback<Ptr<const Data>, Ptr<const Face> > m_prepushedData;
+	TracedCallback<Ptr<const Data>, Time> m_prepushUsed;
+	// Face of a rule whose lease ran out, true for a Data redirect rule
+	TracedCallback<Ptr<const Face>, bool> m_redirectExpired;
+
 	typedef GreenYellowRed super;
 
       };
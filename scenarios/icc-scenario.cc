@@ -74,6 +74,9 @@ namespace br = boost::random;
 #include <ns3-dev/ns3/ndnSIM/model/pit/ndn-pit-entry-incoming-face.h>
 #include <ns3-dev/ns3/ndnSIM/model/pit/ndn-pit-entry-outgoing-face.h>
 
+#include "ap-grid-index.h"
+#include "handoff-scheduler.h"
+#include "icc-topology.h"
 
 typedef struct timeval TIMER_TYPE;
 #define TIMER_NOW(_t) gettimeofday (&_t,NULL);
@@ -103,8 +106,8 @@ double obtain_Num(double min, double max)
 	return dist(gen);
 }
 
-// Function to change the SSID of a Node, depending on distance
-void SetSSIDviaDistance(uint32_t mtId, Ptr<MobilityModel> node, std::map<std::string, Ptr<MobilityModel> > aps)
+// Function to change the SSID of a Node to the closest AP
+void SetSSIDviaDistance(uint32_t mtId, std::string ssid)
 {
 	char configbuf[250];
 	char buffer[250];
@@ -112,27 +115,11 @@ void SetSSIDviaDistance(uint32_t mtId, Ptr<MobilityModel> node, std::map<std::st
 	// This causes the device in mtId to change the SSID, forcing AP change
 	sprintf(configbuf, "/NodeList/%d/DeviceList/0/$ns3::WifiNetDevice/Mac/Ssid", mtId);
 
-	std::map<double, std::string> SsidDistance;
-
-	// Iterate through the map of seen Ssids
-	for (std::map<std::string, Ptr<MobilityModel> >::iterator ii=aps.begin(); ii!=aps.end(); ++ii)
-	{
-		// Calculate the distance from the AP to the node and save into the map
-		SsidDistance[node->GetDistanceFrom((*ii).second)] = (*ii).first;
-	}
-
-	double distance = SsidDistance.begin()->first;
-	std::string ssid(SsidDistance.begin()->second);
-
-	sprintf(buffer, "Change to SSID %s at distance of %f", ssid.c_str(), distance);
+	sprintf(buffer, "Change to SSID %s", ssid.c_str());
 
 	NS_LOG_INFO(buffer);
 
-	// Because the map sorts by std:less, the first position has the lowest distance
 	Config::Set(configbuf, SsidValue(ssid));
-
-	// Empty the maps
-	SsidDistance.clear();
 }
 
 // Function to change the SSID of a node's Wifi netdevice
@@ -193,11 +180,11 @@ PeriodicPitPrinter (Ptr<Node> node)
 int main (int argc, char *argv[])
 {
 	// These are our scenario arguments
-	uint32_t sectors = 2;                         // Number of wireless sectors
-	uint32_t aps = 2;					          // Number of wireless access nodes in a sector
 	uint32_t mobile = 1;				          // Number of mobile terminals
 	uint32_t servers = 1;				          // Number of servers in the network
-	uint32_t wnodes = aps * sectors;              // Number of nodes in the network
+	uint32_t wnodes = 0;                          // Number of wireless access nodes, set by the topology
+	std::string topologyFile;                     // Servers, central nodes and APs to build (empty for the default)
+	std::string hexFile;                          // Hexagon deployment from random/hexagon-random.py to build instead
 	uint32_t xaxis = 300;                         // Size of the X axis
 	uint32_t yaxis = 300;                         // Size of the Y axis
 	double sec = 0.0;                             // Movement start
@@ -215,6 +202,7 @@ int main (int argc, char *argv[])
 	int maxSeq = -1;                              // Maximum number of Data packets to request
 	double retxtime = 0.05;                       // How frequent Interest retransmission timeouts should be checked (seconds)
 	int csSize = 10000000;                        // How big the Content Store should be
+	bool window = false;                          // Let an AIMD window set the Interest rate instead of mbps
 	//double deltaTime = 10;
         std::string nsTFile;                          // Name of the NS Trace file to use
 	char nsTDir[250] = "./Waypoints";           // Directory for the waypoint files
@@ -225,6 +213,8 @@ int main (int argc, char *argv[])
 	CommandLine cmd;
 	cmd.AddValue ("mobile", "Number of mobile terminals in simulation", mobile);
 	cmd.AddValue ("servers", "Number of servers in the simulation", servers);
+	cmd.AddValue ("topology", "File declaring the servers, central nodes, APs and links (default 1 server, 2 sectors of 2 APs)", topologyFile);
+	cmd.AddValue ("hex", "Build the hexagon deployment in this file, one sector per gateway (see random/hexagon-random.py)", hexFile);
 	cmd.AddValue ("results", "Directory to place results", results);
 	cmd.AddValue ("start", "Starting second", sec);
 	cmd.AddValue ("fake", "Enable fake interest", fake);
@@ -232,6 +222,7 @@ int main (int argc, char *argv[])
 	cmd.AddValue ("smart", "Enable SmartFlooding forwarding", smart);
 	cmd.AddValue ("bestr", "Enable BestRoute forwarding", bestr);
 	cmd.AddValue ("csSize", "Number of Interests a Content Store can maintain", csSize);
+	cmd.AddValue ("window", "Send Interests as an AIMD window allows instead of at the mbps rate", window);
 	cmd.AddValue ("walk", "Enable random walk at walking speed", walk);
 	cmd.AddValue ("speed", "Number of speed/hour of mobile terminals in the simulation", speed);
 	cmd.AddValue ("endTime", "How long the simulation will last (Seconds)", endTime);
@@ -295,24 +286,6 @@ int main (int argc, char *argv[])
 	cout << "endtime=" << endTime << endl;
 
 
-	vector<double> centralXpos;
-	vector<double> centralYpos;
-	centralXpos.push_back(50.0);
-	centralXpos.push_back(250.0);
-	centralYpos.push_back(-50.0);
-	centralYpos.push_back(-50.0);
-
-	vector<double> wirelessXpos;
-	vector<double> wirelessYpos;
-	wirelessXpos.push_back(0);
-	wirelessXpos.push_back(100);
-	wirelessXpos.push_back(200);
-	wirelessXpos.push_back(300);
-	wirelessYpos.push_back(0);
-	wirelessYpos.push_back(0);
-	wirelessYpos.push_back(0);
-	wirelessYpos.push_back(0);
-
 	 // What the NDN Data packet payload size is fixed to 1024 bytes
 	uint32_t payLoadsize = 1024;
 
@@ -340,41 +313,37 @@ int main (int argc, char *argv[])
 		mobileNodeIds.push_back(mobileTerminalContainer.Get (i)->GetId ());
 	}
 
-	// Central Nodes
-	NodeContainer centralContainer;
-	centralContainer.Create (sectors);
+	// Central, wireless access and server nodes
+	IccTopology topology;
 
-	// Wireless access Nodes
-	NodeContainer wirelessContainer;
-	wirelessContainer.Create (wnodes);
-
-	// Separate the wireless nodes into sector specific containers
-	std::vector<NodeContainer> sectorNodes;
-
-	for (int i = 0; i < sectors; i++)
+	if (!hexFile.empty ())
 	{
-		NodeContainer wireless;
-		for (int j = i*aps; j < aps + i*aps; j++)
-		{
-			wireless.Add(wirelessContainer.Get (j));
-		}
-		sectorNodes.push_back(wireless);
+		if (!topology.LoadHexagon (hexFile, servers))
+			NS_FATAL_ERROR (topology.GetError ());
+	}
+	else if (topologyFile.empty ())
+	{
+		topology.LoadDefault (servers);
+	}
+	else if (!topology.Load (topologyFile))
+	{
+		NS_FATAL_ERROR (topology.GetError ());
 	}
 
-	// Find out how many first level nodes we will have
-	// The +1 is for the server which will be attached to the first level nodes
-	int first = (sectors / 3) + 1;
+	topology.Build ();
+
+	NodeContainer centralContainer = topology.GetCentrals ();
+	NodeContainer wirelessContainer = topology.GetAps ();
+	NodeContainer serverNodes = topology.GetServers ();
 
+	wnodes = wirelessContainer.GetN ();
+	servers = serverNodes.GetN ();
 
 	// Container for all NDN capable nodes
 	NodeContainer allNdnNodes;
 	allNdnNodes.Add (centralContainer);
 	allNdnNodes.Add (wirelessContainer);
 
-	// Container for server (producer) nodes
-	NodeContainer serverNodes;
-	serverNodes.Create (servers);
-
 	std::vector<uint32_t> serverNodeIds;
 
 	// Save all the mobile Node IDs
@@ -388,59 +357,9 @@ int main (int argc, char *argv[])
 	allUserNodes.Add (mobileTerminalContainer);
 	allUserNodes.Add (serverNodes);
 
-	// Container for each AP to be identified
-	NodeContainer SSID1;
-	SSID1.Add (wirelessContainer.Get(0));
-	NodeContainer SSID2;
-	SSID2.Add (wirelessContainer.Get(1));
-	NodeContainer SSID3;
-	SSID3.Add (wirelessContainer.Get(2));
-	NodeContainer SSID4;
-	SSID4.Add (wirelessContainer.Get(3));
-
 	// Make sure to seed our random
 	gen.seed (std::time (0) + (long long)getpid () << 32);
 
-	MobilityHelper Server;
-	Ptr<ListPositionAllocator> initialServer = CreateObject<ListPositionAllocator> ();
-
-	Vector posServer (150, -100, 0.0);
-	initialServer->Add (posServer);
-
-	Server.SetPositionAllocator(initialServer);
-	Server.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
-	Server.Install(serverNodes);
-
-	NS_LOG_INFO ("------Placing Central nodes-------");
-	MobilityHelper centralStations;
-
-	Ptr<ListPositionAllocator> initialCenter = CreateObject<ListPositionAllocator> ();
-
-	for (int i = 0; i < sectors; i++)
-	{
-		Vector pos (centralXpos[i], centralYpos[i], 0.0);
-		initialCenter->Add (pos);
-	}
-
-	centralStations.SetPositionAllocator(initialCenter);
-	centralStations.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
-	centralStations.Install(centralContainer);
-
-	NS_LOG_INFO ("------Placing wireless access nodes------");
-	MobilityHelper wirelessStations;
-
-	Ptr<ListPositionAllocator> initialWireless = CreateObject<ListPositionAllocator> ();
-
-	for (int i = 0; i < wnodes; i++)
-	{
-		Vector pos (wirelessXpos[i], wirelessYpos[i], 0.0);
-		initialWireless->Add (pos);
-	}
-
-	wirelessStations.SetPositionAllocator(initialWireless);
-	wirelessStations.SetMobilityModel("ns3::ConstantPositionMobilityModel");
-	wirelessStations.Install(wirelessContainer);
-
 	NS_LOG_INFO ("------Placing mobile node and determining direction and speed------");
 	MobilityHelper mobileStations;
 
@@ -455,37 +374,6 @@ int main (int argc, char *argv[])
 	Ns2MobilityHelper ns2 = Ns2MobilityHelper (nsTFile);
 	ns2.Install ();
 
-	// Connect Wireless Nodes to central nodes
-	// Because the simulation is using Wifi, PtP connections are 100Mbps
-	// with 5ms delay
-	NS_LOG_INFO("------Connecting Central nodes to wireless access nodes------");
-
-	vector <NetDeviceContainer> ptpWLANCenterDevices;
-
-	PointToPointHelper p2p_100mbps5ms;
-	p2p_100mbps5ms.SetDeviceAttribute ("DataRate", StringValue ("100Mbps"));
-	p2p_100mbps5ms.SetChannelAttribute ("Delay", StringValue ("1ms"));
-
-	for (int i = 0; i < sectors; i++)
-	{
-		NetDeviceContainer ptpWirelessCenterDevices;
-
-		for (int j = 0; j < aps; j++)
-		{
-			ptpWirelessCenterDevices.Add (p2p_100mbps5ms.Install (centralContainer.Get (i), sectorNodes[i].Get (j) ));
-		}
-
-		ptpWLANCenterDevices.push_back (ptpWirelessCenterDevices);
-	}
-
-	// Connect the server to central node
-	NetDeviceContainer ptpServerlowerNdnDevices;
-	for(int i =0; i < sectors; i++){
-		ptpServerlowerNdnDevices.Add (p2p_100mbps5ms.Install (serverNodes.Get (0), centralContainer.Get (i)));
-
-	}
-
-
 	NS_LOG_INFO ("------Creating Wireless cards------");
 
 	// Use the Wifi Helper to define the wireless interfaces for APs
@@ -523,9 +411,8 @@ int main (int argc, char *argv[])
 
 	NS_LOG_INFO ("------Creating ssids for wireless cards------");
 
-	// We store the Wifi AP mobility models in a map, ordered by the ssid string. Will be easier to manage when
-	// calling the modified StaMApWifiMac
-	std::map<std::string, Ptr<MobilityModel> > apTerminalMobility;
+	// We index the Wifi AP positions by ssid, built once to find the closest AP to each mobile
+	ApGridIndex apTerminalMobility;
 
 	for (int i = 0; i < wnodes; i++)
 	{
@@ -538,10 +425,12 @@ int main (int argc, char *argv[])
 		// Get the mobility model for wnode i
 		Ptr<MobilityModel> tmp = (wirelessContainer.Get (i))->GetObject<MobilityModel> ();
 
-		// Store the information into our map
-		apTerminalMobility[ssidtmp] = tmp;
+		// Store the information into our index
+		apTerminalMobility.Add (ssidtmp, tmp->GetPosition ());
 	}
 
+	apTerminalMobility.Build ();
+
 	NS_LOG_INFO ("------Assigning mobile terminal wireless cards------");
 
 	NS_LOG_INFO ("Assigning AP wireless cards");
@@ -634,9 +523,11 @@ int main (int argc, char *argv[])
 	NS_LOG_INFO (buffer);
 
 	// Create the consumer on the randomly selected node
-	ndn::AppHelper consumerHelper ("ns3::ndn::ConsumerCbr");
+	ndn::AppHelper consumerHelper (window ? "ns3::ndn::PriConsumer" : "ns3::ndn::ConsumerCbr");
 	consumerHelper.SetPrefix ("/waseda/sato");
 	consumerHelper.SetAttribute ("Frequency", DoubleValue (intFreq));
+	if (window)
+		consumerHelper.SetAttribute ("WindowControl", BooleanValue (true));
 	consumerHelper.SetAttribute ("StartTime", TimeValue (Seconds(1)));
 	consumerHelper.SetAttribute ("StopTime", TimeValue (Seconds(endTime)));
 	consumerHelper.SetAttribute ("RetxTimer", TimeValue (Seconds(retxtime)));
@@ -716,38 +607,22 @@ int main (int argc, char *argv[])
 
 	NS_LOG_INFO ("------Scheduling events - SSID changes------");
 
-	// Schedule AP Changes
+	// Schedule AP Changes, every mobile is handed to the closest AP whenever
+	// its trajectory crosses into another AP's area
 	double apsec = 0.0;
-	// How often should the AP check it's distance
-	double checkTime = 100.0/realspeed;
-	double j = apsec;
-	int k = 0;
+	std::vector<Ptr<HandoffScheduler> > handoffSchedulers;
 
-	while ( j < endTime)
+	for (int i = 0; i < mobile; i++)
 	{
-		sprintf(buffer, "Running event at %f", j);
-		NS_LOG_INFO(buffer);
+		Ptr<HandoffScheduler> handoff = Create<HandoffScheduler> (mobileTerminalsMobility[i], &apTerminalMobility);
 
-		for (int i = 0; i < mobile && k < 4; i++)
-		{
-			Simulator::Schedule (Seconds(j), &SetSSID, mobileNodeIds[0], 0, ssidV[k]);
-		}
+		handoff->SetHandoffCallback (MakeBoundCallback (&SetSSIDviaDistance, mobileNodeIds[i]));
 
-		/*
-		NS_LOG_INFO ("------Testing PIT printing------");
-		for (int i = 0; i < 6; i++)
-		{
-			sprintf(buffer, "Running event at %f", j+i);
-			cout << buffer << endl;
-			Simulator::Schedule (Seconds(j+i), &PeriodicPitPrinter, mobileTerminalContainer.Get(0));
-		}*/
-
-		j += checkTime;
-		k++;
+		Simulator::Schedule (Seconds (apsec), &HandoffScheduler::Start, handoff);
+		Simulator::Schedule (Seconds (endTime), &HandoffScheduler::Stop, handoff);
+		handoffSchedulers.push_back (handoff);
 	}
 
-
-
 	NS_LOG_INFO ("------Ready for execution!------");
 
 	Simulator::Stop (Seconds (endTime+1));
@@ -78,7 +78,11 @@ namespace br = boost::random;
 #include <ns3-dev/ns3/ndnSIM/apps/ndn-consumer.h>
 #include <ns3-dev/ns3/ndnSIM/apps/ndn-consumer-cbr.h>
 
+#include "ap-grid-index.h"
+#include "handoff-scheduler.h"
+#include "icc-topology.h"
 #include "ndn-priconsumer.h"
+#include "ndn-replay-consumer.h"
 #include "smart-flooding-inf.h"
 
 
@@ -95,21 +99,17 @@ NS_LOG_COMPONENT_DEFINE (scenario);
 br::mt19937_64 gen;
 
 // Global information to use in callbacks
-std::set<uint32_t> res;
-std::map<Mac48Address,Ptr<Node> > seen_macs;
+SeqRangeSet res;
 std::map<int, Ptr<Node> > numToNode;
 std::map<std::string, Ptr<Node> > ssidToNode;
-std::map<std::string, int> ssidToNum;
 NodeContainer NCaps;
 NodeContainer NCcenters;
 NodeContainer NCmobiles;
 NodeContainer NCservers;
+IccTopology topology;
 
-std::vector<Mac48Address> mac_queue;
-uint32_t numqueue = 0;
-bool sectorChange = false;
-bool readEntry = false;
-std::string ssidOld = "";
+// Content Store hits and misses per node
+std::map<uint32_t, std::pair<uint64_t, uint64_t> > cacheStats;
 
 std::vector<YansWifiPhyHelper> yanhelpers;
 std::map<uint32_t, Ptr<YansWifiChannel> > channels;
@@ -132,34 +132,28 @@ double obtain_Num(double min, double max)
 
 
 
+// Reused by PrintSeqs
+std::vector<uint32_t> seqDelta;
+
 void PrintSeqs (Ptr<PriConsumer> consumer)
 {
   cout << "Printing sequence numbers to distribute " << Simulator::Now () << endl;
 
-  std::set<uint32_t> seqset = consumer->GetSeqTimeout ();
-  cout << "Survived the class grab" << endl;
-  std::set<uint32_t>::iterator it;
-
-  std::set<uint32_t> diff;
-
-  std::set_difference(seqset.begin(), seqset.end(), res.begin(), res.end(),
-		      std::inserter(diff, diff.begin()));
+  // Only the sequences that timed out since the last call
+  consumer->GetSeqTimeoutDelta (seqDelta);
 
-  cout << "Retransmission packet number: " << diff.size () << endl;
+  cout << "Retransmission packet number: " << seqDelta.size () << endl;
 
-  std::cout << "diff now contains:";
-  for (it=diff.begin(); it!=diff.end(); ++it)
+  std::cout << "delta now contains:";
+  for (std::vector<uint32_t>::iterator it = seqDelta.begin (); it != seqDelta.end (); ++it)
     std::cout << ' ' << *it;
   std::cout << '\n';
 
-  res.insert(diff.begin(), diff.end());
+  for (std::vector<uint32_t>::iterator it = seqDelta.begin (); it != seqDelta.end (); ++it)
+    res.Insert (*it);
 
-  cout << "res size is " << res.size() << endl;
-
-  std::cout << "res now contains:";
-  for (it=res.begin(); it!=res.end(); ++it)
-    std::cout << ' ' << *it;
-  std::cout << '\n';
+  cout << "res size is " << res.GetCount () << " in " << res.GetRanges () << " ranges" << endl;
+  cout << "res now contains: " << res << endl;
 
   cout << "______________________________" << endl;
 }
@@ -190,7 +184,6 @@ SetSSID (uint32_t mtId, uint32_t deviceId, Ssid ssidName)
   //
   //	Config::Set(configbuf, PointerValue(channels[mtId]));
 
-  sectorChange = true;
   cout << "||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||" << endl;
 }
 
@@ -234,8 +227,10 @@ INFObtained (Ptr<Node> n_node, uint32_t faceId)
   cout << "Leaving INFObtained" << endl;
 }
 
+// Redirect the Data under prefix on behalf of consumer, 0 for a rule
+// shared by everybody
 void
-setupRedirection (Ptr<Node> n_node, uint32_t faceId, Time start)
+setupRedirection (Ptr<Node> n_node, uint32_t faceId, Time start, const Name &prefix = Name ("/"), uint32_t consumer = 0)
 {
   cout << "____________________________________________________________" << endl;
   cout << "Setting up Interest Sector redirection for node " << n_node->GetId () << endl;
@@ -250,14 +245,14 @@ setupRedirection (Ptr<Node> n_node, uint32_t faceId, Time start)
 	{
 	  cout << "Sector redirection is already on, adding new info" << endl;
 	  cout << "Adding Face " << faceId << endl;
-	  stra->redirectFaces.insert(n_face);
+	  stra->AddRedirectRule (prefix, consumer, n_face);
 	} else
 	  {
 	    cout << "Start: " << start << endl;
 	    cout << "Adding Face " << faceId << endl;
 	    stra->m_start = start;
 	    stra->m_redirect = true;
-	    stra->redirectFaces.insert(n_face);
+	    stra->AddRedirectRule (prefix, consumer, n_face);
 	  }
     }else
       {
@@ -268,7 +263,7 @@ setupRedirection (Ptr<Node> n_node, uint32_t faceId, Time start)
 }
 
 void
-setupDataRedirection (Ptr<Node> n_node, uint32_t faceId, Time start)
+setupDataRedirection (Ptr<Node> n_node, uint32_t faceId, Time start, const Name &prefix = Name ("/"), uint32_t consumer = 0)
 {
   cout << "++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++" << endl;
   cout << "Setting up Data only redirection for node " << n_node->GetId () << endl;
@@ -283,7 +278,7 @@ setupDataRedirection (Ptr<Node> n_node, uint32_t faceId, Time start)
 	{
 	  cout << "Data redirection is already on, adding new info" << endl;
 	  cout << "Adding Face " << faceId << endl;
-	  stra->dataRedirect.insert(n_face);
+	  stra->AddDataRedirectRule (prefix, consumer, n_face);
 	} else
 	  {
 
@@ -291,7 +286,7 @@ setupDataRedirection (Ptr<Node> n_node, uint32_t faceId, Time start)
 	    cout << "Adding Face " << faceId << endl;
 	    stra->m_start = start;
 	    stra->m_data_redirect = true;
-	    stra->dataRedirect.insert(n_face);
+	    stra->AddDataRedirectRule (prefix, consumer, n_face);
 	  }
     } else
       {
@@ -306,8 +301,7 @@ turnoffDataRedirection (Ptr<Node> n_node)
   cout << "------------------------------------------------------------" << endl;
   cout << "Turning off Data redirect for node " << n_node->GetId () <<  " at " << Simulator::Now () << endl;
   Ptr<fw::SmartFloodingInf> stra = n_node->GetObject <fw::SmartFloodingInf> ();
-  stra->m_data_redirect = false;
-  //stra->dataRedirect.clear();
+  stra->ClearDataRedirection ();
   cout << "------------------------------------------------------------" << endl;
 }
 
@@ -317,8 +311,42 @@ turnoffRedirection (Ptr<Node> n_node)
   cout << "------------------------------------------------------------" << endl;
   cout << "Turning off sector redirect for node " << n_node->GetId () <<  " at " << Simulator::Now () << endl;
   Ptr<fw::SmartFloodingInf> stra = n_node->GetObject <fw::SmartFloodingInf> ();
-  stra->m_redirect = false;
-  //stra->redirectFaces.clear();
+  stra->ClearRedirection ();
+  cout << "------------------------------------------------------------" << endl;
+}
+
+// Drop a single sector or Data redirection rule
+void
+removeRedirectionRule (Ptr<Node> n_node, uint32_t faceId, bool data, const Name &prefix, uint32_t consumer)
+{
+  cout << "------------------------------------------------------------" << endl;
+  cout << "Removing " << (data ? "Data" : "sector") << " redirect through Face " << faceId
+      << " for node " << n_node->GetId () <<  " at " << Simulator::Now () << endl;
+  Ptr<fw::SmartFloodingInf> stra = n_node->GetObject <fw::SmartFloodingInf> ();
+  Ptr<Face> n_face = n_node->GetObject <L3Protocol> ()->GetFaceById (faceId);
+
+  if (n_face == 0)
+    return;
+
+  if (data)
+    stra->RemoveDataRedirectRule (prefix, consumer, n_face);
+  else
+    stra->RemoveRedirectRule (prefix, consumer, n_face);
+}
+
+// Drop the sector or Data redirection rules of one consumer
+void
+turnoffConsumerRedirection (Ptr<Node> n_node, bool data, const Name &prefix, uint32_t consumer)
+{
+  cout << "------------------------------------------------------------" << endl;
+  cout << "Turning off " << (data ? "Data" : "sector") << " redirect of consumer " << consumer
+      << " for node " << n_node->GetId () <<  " at " << Simulator::Now () << endl;
+  Ptr<fw::SmartFloodingInf> stra = n_node->GetObject <fw::SmartFloodingInf> ();
+
+  if (data)
+    stra->RemoveDataRedirectRules (prefix, consumer);
+  else
+    stra->RemoveRedirectRules (prefix, consumer);
   cout << "------------------------------------------------------------" << endl;
 }
 
@@ -376,6 +404,148 @@ flushNodeBuffer (Ptr<Node> n_node, Ptr<Face> face)
   stra->flushBuffer(face);
 }
 
+// Record every finished buffer flush of the SmartFloodingInf strategy
+void
+FlushEndTrace (Ptr<OutputStreamWrapper> stream, Ptr<const Face> face, const fw::FlushStats &stats)
+{
+  *stream->GetStream () << Simulator::Now ().GetSeconds () << "\t"
+      << face->GetNode ()->GetId () << "\t"
+      << face->GetId () << "\t"
+      << stats.backlog << "\t"
+      << stats.sent << "\t"
+      << stats.dropped << "\t"
+      << stats.skipped << "\t"
+      << stats.duration.GetSeconds () << endl;
+}
+
+void
+turnOffPrepush (Ptr<Node> n_node)
+{
+  Ptr<fw::SmartFloodingInf> stra = n_node->GetObject <fw::SmartFloodingInf> ();
+  stra->m_prepush = false;
+}
+
+void
+PrintPrepushStats (NodeContainer nc)
+{
+  uint64_t prepushed = 0;
+  uint64_t used = 0;
+
+  for (uint32_t i = 0; i < nc.GetN (); i++)
+    {
+      Ptr<fw::SmartFloodingInf> stra = nc.Get (i)->GetObject <fw::SmartFloodingInf> ();
+      const fw::RedirectCounters &counters = stra->GetCounters ();
+
+      cout << "Node " << nc.Get (i)->GetId () << " pre-pushed " << counters.prepushed
+	  << ", used " << counters.prepushUsed << endl;
+
+      prepushed += counters.prepushed;
+      used += counters.prepushUsed;
+    }
+
+  cout << "Pre-pushed " << prepushed << ", used " << used;
+  if (prepushed > 0)
+    cout << " (" << (100.0 * used) / prepushed << "%)";
+  cout << endl;
+}
+
+void
+PrintDeliveryLine (const char *label, const DeliveryCounters &d)
+{
+  uint64_t wasted = d.duplicateBytes + d.lateBytes + d.unsolicitedBytes;
+
+  cout << label << " useful " << d.useful << " (" << d.usefulBytes << " B)"
+      << ", duplicate " << d.duplicate << " (" << d.duplicateBytes << " B)"
+      << ", late " << d.late << " (" << d.lateBytes << " B)"
+      << ", unsolicited " << d.unsolicited << " (" << d.unsolicitedBytes << " B)";
+  if (wasted + d.usefulBytes > 0)
+    cout << ", wasted " << (100.0 * wasted) / (wasted + d.usefulBytes) << "%";
+  cout << endl;
+}
+
+void
+PrintDeliveries (Ptr<PriConsumer> consumer)
+{
+  const std::vector<DeliveryCounters> &epochs = consumer->GetHandoffDeliveries ();
+  char label[32];
+
+  for (uint32_t i = 0; i < epochs.size (); i++)
+    {
+      sprintf (label, "Handoff %d", i);
+      PrintDeliveryLine (label, epochs[i]);
+    }
+
+  PrintDeliveryLine ("Data", consumer->GetDeliveries ());
+}
+
+void
+CountCacheHit (uint32_t node, Ptr<const Interest> interest, Ptr<const Data> data)
+{
+  cacheStats[node].first++;
+}
+
+void
+CountCacheMiss (uint32_t node, Ptr<const Interest> interest)
+{
+  cacheStats[node].second++;
+}
+
+void
+WatchCaches (NodeContainer nc)
+{
+  for (uint32_t i = 0; i < nc.GetN (); i++)
+    {
+      Ptr<ContentStore> cs = nc.Get (i)->GetObject<ContentStore> ();
+      uint32_t id = nc.Get (i)->GetId ();
+
+      cs->TraceConnectWithoutContext ("CacheHits", MakeBoundCallback (&CountCacheHit, id));
+      cs->TraceConnectWithoutContext ("CacheMisses", MakeBoundCallback (&CountCacheMiss, id));
+    }
+}
+
+void
+PrintCacheStats (NodeContainer nc)
+{
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+
+  for (uint32_t i = 0; i < nc.GetN (); i++)
+    {
+      uint32_t id = nc.Get (i)->GetId ();
+      std::pair<uint64_t, uint64_t> counts = cacheStats[id];
+
+      cout << "Node " << id << " CS hits " << counts.first << ", misses " << counts.second;
+      if (counts.first + counts.second > 0)
+	cout << " (" << (100.0 * counts.first) / (counts.first + counts.second) << "%)";
+      cout << ", entries " << nc.Get (i)->GetObject<ContentStore> ()->GetSize () << endl;
+
+      hits += counts.first;
+      misses += counts.second;
+    }
+
+  cout << "CS hits " << hits << ", misses " << misses;
+  if (hits + misses > 0)
+    cout << " (" << (100.0 * hits) / (hits + misses) << "%)";
+  cout << endl;
+}
+
+void
+PrintStoreStats (NodeContainer nc)
+{
+  for (uint32_t i = 0; i < nc.GetN (); i++)
+    {
+      Ptr<fw::SmartFloodingInf> stra = nc.Get (i)->GetObject <fw::SmartFloodingInf> ();
+      const fw::RedirectCounters &counters = stra->GetCounters ();
+
+      cout << "Node " << nc.Get (i)->GetId ()
+	  << " CS hits " << counters.mainStore.hits << ", misses " << counters.mainStore.misses
+	  << " | redirect store hits " << counters.redirectStore.hits
+	  << ", misses " << counters.redirectStore.misses
+	  << ", admitted " << counters.redirectStore.admitted
+	  << ", rejected " << counters.redirectStore.rejected << endl;
+    }
+}
+
 uint32_t
 getNodeBufferSize (Ptr<Node> n_node)
 {
@@ -383,109 +553,317 @@ getNodeBufferSize (Ptr<Node> n_node)
   return stra->bufferSize();
 }
 
-//firstAssociatedPacket(Ptr<const Interest> interest, Ptr<const Face> face)
+// Names a mobile asks for when several share the network
+std::string
+mobilePrefix (Ptr<Node> mobile)
+{
+  return "/waseda/sato/" + boost::lexical_cast<std::string> (mobile->GetId ());
+}
+
+/**
+ * \brief Handoff state of one mobile terminal
+ *
+ * Keeps what each mobile needs to follow its own handoffs, so several
+ * mobiles can hand off through the same nodes. With a consumer id other
+ * than 0 the redirection rules only cover the Data under the mobile's
+ * prefix and are removed without touching the rules of other mobiles.
+ */
+class MobileHandoff : public SimpleRefCount<MobileHandoff>
+{
+public:
+  MobileHandoff (uint32_t mtId, bool smartInf, const Name &prefix, uint32_t consumer);
+
+  // Function to change the SSID of the mobile, depending on distance
+  void
+  SetSSIDviaDistance (std::string ssid);
+
+  // Pre-push towards the AP the mobile is about to be handed to
+  void
+  PredictHandoff (std::string current, std::string ssid);
+
+  void
+  apAssociation (const Mac48Address mac);
+
+private:
+  // Set up, or with install false remove, the redirection copying the
+  // Data the mobile retrieves to next
+  void
+  prepushTowards (std::string current, std::string next, bool install = true);
+
+  void
+  setupHandoffRedirection (Ptr<Node> from, Ptr<Node> to);
+
+  void
+  firstAssociatedPacket (Ptr<Node> tmp);
+
+  // Turn off the sector or Data redirection the mobile set up on a node
+  void
+  ClearRules (Ptr<Node> n_node, bool data);
+
+  uint32_t m_mtId;
+  bool m_smartInf;
+  Name m_prefix;
+  uint32_t m_consumer;
+
+  std::map<Mac48Address,Ptr<Node> > m_seenMacs;
+  std::vector<Mac48Address> m_macQueue;
+  Ptr<Node> m_handoffFrom;
+  bool m_sectorChange;
+  bool m_readEntry;
+  std::string m_ssidOld;
+  std::string m_ssidPredicted;
+  // SSID the mobile was on when the prediction was made
+  std::string m_ssidPredictedFrom;
+};
+
+MobileHandoff::MobileHandoff (uint32_t mtId, bool smartInf, const Name &prefix, uint32_t consumer)
+  : m_mtId (mtId)
+  , m_smartInf (smartInf)
+  , m_prefix (prefix)
+  , m_consumer (consumer)
+  , m_sectorChange (false)
+  , m_readEntry (false)
+{
+}
+
+void
+MobileHandoff::ClearRules (Ptr<Node> n_node, bool data)
+{
+  if (m_consumer != 0)
+    turnoffConsumerRedirection (n_node, data, m_prefix, m_consumer);
+  else if (data)
+    turnoffDataRedirection (n_node);
+  else
+    turnoffRedirection (n_node);
+}
+
+/**
+ * \brief Start copying the Data the mobile retrieves to the AP it is expected to join
+ * \param current SSID of the AP the mobile is associated to
+ * \param next SSID of the AP the mobile is expected to associate to
+ * \param install false to remove the rules of an earlier call instead
+ */
 void
-firstAssociatedPacket(Ptr<Node> tmp)
+MobileHandoff::prepushTowards (std::string current, std::string next, bool install)
 {
-  if (readEntry)
+  Time now = Simulator::Now ();
+  Ptr<Node> ap = ssidToNode[next];
+  Ptr<Node> central = topology.GetUpstream (ap);
+  Ptr<Node> oldCentral = topology.GetUpstream (ssidToNode[current]);
+
+  if (central == 0 || oldCentral == 0)
     {
-      // Check to see if there is anything on the node to push on sector nodes
-      switch (numqueue)
-      {
-	case 1:
+      cout << "No central node for " << next << endl;
+      return;
+    }
 
-	  setPassthrough(tmp);
+  Ptr<Face> down = GetFaceTowards (central, ap);
 
-	  turnoffDataRedirection(tmp);
+  if (down == 0)
+    {
+      cout << "No link from node " << central->GetId () << " to " << ap->GetId () << endl;
+      return;
+    }
 
-	  turnOffPassthrough(tmp);
+  uint32_t downId = down->GetId ();
 
-	  turnoffRedirection(NCcenters.Get (0));
+  if (!install)
+    {
+      cout << "Stop pre-pushing to node " << ap->GetId () << " at " << now << endl;
+      turnOffPrepush (ap);
 
-	  //turnoffRedirection(NCcenters.Get (0));
-	  //turnoffDataRedirection(NCcenters.Get (0));
-	  //flushNodeBuffer(NCcenters.Get (0));
+      if (central == oldCentral)
+	removeRedirectionRule (central, downId, false, m_prefix, m_consumer);
+      else
+	{
+	  Ptr<Face> face = GetFaceTowards (topology.GetUpstream (oldCentral), central);
 
-	  //tmp = numToNode[1];
-	  //turnoffDataRedirection(tmp);
-	  //flushNodeBuffer(tmp);
+	  if (face != 0)
+	    removeRedirectionRule (topology.GetUpstream (oldCentral), face->GetId (), false, m_prefix, m_consumer);
+	  removeRedirectionRule (central, downId, true, m_prefix, m_consumer);
+	}
+      return;
+    }
 
-	  break;
-	case 2:
-	  setPassthrough(NCaps.Get (2));
-	  setPassthrough(NCcenters.Get(1));
+  cout << "Pre-pushing to node " << ap->GetId () << " at " << now << endl;
 
-	  turnoffDataRedirection(NCaps.Get (2));
-	  turnoffDataRedirection(NCaps.Get (1));
+  Ptr<fw::SmartFloodingInf> stra = ap->GetObject <fw::SmartFloodingInf> ();
+  stra->m_prepush = true;
 
-	  turnOffPassthrough(NCaps.Get (2));
-	  turnOffPassthrough(NCcenters.Get(1));
+  if (central == oldCentral)
+    {
+      // Same sector, the central node already sees all the Data
+      setupRedirection (central, downId, now, m_prefix, m_consumer);
+    }
+  else
+    {
+      // Different sector, the server copies the Data to the next central node
+      Ptr<Node> server = topology.GetUpstream (oldCentral);
+      Ptr<Face> face = GetFaceTowards (server, central);
 
-	  turnoffRedirection(NCservers.Get (0));
+      if (face == 0)
+	{
+	  cout << "No link from node " << server->GetId () << " to " << central->GetId () << endl;
+	  return;
+	}
 
-//	  turnoffRedirection(NCservers.Get (0));
-//	  turnoffDataRedirection(NCservers.Get (0));
-//	  //flushNodeBuffer(NCservers.Get (0));
-//
-//	  tmp = NCcenters.Get (1);
-//	  turnoffDataRedirection(tmp);
-//	  //flushNodeBuffer(tmp);
-//
-//	  tmp = numToNode[2];
-//	  turnoffDataRedirection(tmp);
-	  //flushNodeBuffer(tmp);
+      setupRedirection (server, face->GetId (), now, m_prefix, m_consumer);
+      setupDataRedirection (central, downId, now, m_prefix, m_consumer);
+    }
+}
+
+// Copy the Data the mobile retrieves through AP from towards AP to, and
+// have to send it over the air, until the mobile associates to to
+void
+MobileHandoff::setupHandoffRedirection (Ptr<Node> from, Ptr<Node> to)
+{
+  Time now = Simulator::Now ();
+  Ptr<Node> central = topology.GetUpstream (to);
+  Ptr<Node> oldCentral = topology.GetUpstream (from);
+
+  if (central == 0 || oldCentral == 0)
+    {
+      cout << "No central node between " << from->GetId () << " and " << to->GetId () << endl;
+      return;
+    }
 
-	  break;
-	case 3:
+  Ptr<Face> down = GetFaceTowards (central, to);
 
-	  setPassthrough(tmp);
+  if (down == 0)
+    {
+      cout << "No link from node " << central->GetId () << " to " << to->GetId () << endl;
+      return;
+    }
 
-	  turnoffDataRedirection(tmp);
+  uint32_t downId = down->GetId ();
 
-	  turnOffPassthrough(tmp);
+  if (central == oldCentral)
+    {
+      // Central node
+      setupRedirection (central, downId, now, m_prefix, m_consumer);
+    }
+  else
+    {
+      // Server
+      Ptr<Node> server = topology.GetUpstream (oldCentral);
+      Ptr<Face> face = GetFaceTowards (server, central);
 
-	  turnoffRedirection(NCcenters.Get (1));
+      if (face == 0)
+	{
+	  cout << "No link from node " << server->GetId () << " to " << central->GetId () << endl;
+	  return;
+	}
 
-	  //tmp = NCcenters.Get (1);
-	  //turnoffDataRedirection(tmp);
-	  //flushNodeBuffer(tmp);
+      setupRedirection (server, face->GetId (), now, m_prefix, m_consumer);
 
-	  //tmp = numToNode[3];
-	  //turnoffDataRedirection(tmp);
-	  //flushNodeBuffer(tmp);
-	  break;
-      }
-      readEntry = false;
+      // Central node
+      setupDataRedirection (central, downId, now, m_prefix, m_consumer);
+    }
+
+  // AP node
+  Ptr<Face> wireless = GetWirelessFace (to);
+
+  if (wireless == 0)
+    {
+      cout << "No wireless face on node " << to->GetId () << endl;
+      return;
+    }
+
+  setupDataRedirection (to, wireless->GetId (), now, m_prefix, m_consumer);
+}
+
+void
+MobileHandoff::PredictHandoff (std::string current, std::string ssid)
+{
+  if (m_ssidOld.empty ())
+    return;
+
+  if (ssid == m_ssidOld || ssid == m_ssidPredicted)
+    return;
+
+  NS_LOG_INFO ("Predicting change from " << m_ssidOld << " to " << ssid);
+
+  // A new prediction replaces the previous one, stop sending Data towards
+  // the AP that was mispredicted
+  if (!m_ssidPredicted.empty () && m_ssidPredicted != m_ssidOld)
+    prepushTowards (m_ssidPredictedFrom, m_ssidPredicted, false);
+
+  m_ssidPredicted = ssid;
+  m_ssidPredictedFrom = m_ssidOld;
+  prepushTowards (m_ssidOld, ssid);
+}
+
+void
+MobileHandoff::firstAssociatedPacket(Ptr<Node> tmp)
+{
+  if (m_readEntry)
+    {
+      // Check to see if there is anything on the node to push on sector nodes
+      if (m_handoffFrom != 0)
+	{
+	  Ptr<Node> central = topology.GetUpstream (tmp);
+	  Ptr<Node> oldCentral = topology.GetUpstream (m_handoffFrom);
+
+	  if (central == oldCentral)
+	    {
+	      setPassthrough(tmp);
+
+	      ClearRules(tmp, true);
+
+	      turnOffPassthrough(tmp);
+
+	      ClearRules(central, false);
+	    }
+	  else
+	    {
+	      setPassthrough(tmp);
+	      setPassthrough(central);
+
+	      ClearRules(tmp, true);
+	      ClearRules(central, true);
+
+	      turnOffPassthrough(tmp);
+	      turnOffPassthrough(central);
+
+	      ClearRules(topology.GetUpstream (oldCentral), false);
+	    }
+
+	  m_handoffFrom = 0;
+	}
+      m_readEntry = false;
     }
 }
 
 void
-apAssociation (const Mac48Address mac)
+MobileHandoff::apAssociation (const Mac48Address mac)
 {
   Time now = Simulator::Now ();
   Ptr<Node> tmp = GetAssociatedNode(NCaps,mac);
 
-  if (seen_macs.empty()) {
+  if (m_seenMacs.empty()) {
       cout << "============================================================" << endl;
       cout << "Associated to node " <<  tmp->GetId() << " at " << now << endl;
       cout << "First time seeing a MAC Address" << endl;
       // We haven't seen any APs, save
-      seen_macs[mac] = tmp;
+      m_seenMacs[mac] = tmp;
 
-      mac_queue.push_back(mac);
-  } else if (seen_macs.find(mac) != seen_macs.end()) {
+      m_macQueue.push_back(mac);
+  } else if (m_seenMacs.find(mac) != m_seenMacs.end()) {
   } else {
       cout << "============================================================" << endl;
       cout << "Associated to node " <<  tmp->GetId() << " at " << now << endl;
       cout << "Hit a new MAC, reassociating" << endl;
 
       // We got something that wasn't in our map, means new AP
-      seen_macs[mac] = tmp;
+      m_seenMacs[mac] = tmp;
 
-      mac_queue.push_back(mac);
+      m_macQueue.push_back(mac);
       cout << "Affecting network with REN/INF" << endl;
 
-      readEntry = true;
+      m_readEntry = true;
+
+      // The AP now has the mobile, nothing more to pre-push
+      turnOffPrepush (tmp);
 
       Ptr<ForwardingStrategy> fw = tmp->GetObject<ForwardingStrategy> ();
 
@@ -493,158 +871,73 @@ apAssociation (const Mac48Address mac)
       firstAssociatedPacket(tmp);
   }
 
-  if (sectorChange)
+  if (m_sectorChange)
     {
       cout << "Executed Sector change" << endl;
-      sectorChange = false;
+      m_sectorChange = false;
     }
 }
 
 void
-apDeassociation (const Mac48Address mac)
-{
-  //cout << "%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%" << endl;
-  //Time now = Simulator::Now ();
-  //Ptr<Node> tmp = GetAssociatedNode(NCaps,mac);
-  //cout << "Deassociated from node " << tmp->GetId() << " at " << now << endl;
-
-  //	if (sectorChange) {
-  //		cout << "Executing sector change!" << endl;
-  //		cout << "Affecting Network with DEN!" << endl;
-  //
-  //		// Code needed when using one shared channel for all Wifi
-  //		switch (numqueue)
-  //		{
-  //		case 1:
-  //			setupRedirection(NCcenters.Get (0), 1, now);
-  //			setupDataRedirection(NCaps.Get (1), 1, now);
-  //			break;
-  //		case 2:
-  //			setupRedirection(NCservers.Get (0), 1, now);
-  //			setupDataRedirection(NCcenters.Get(1), 0, now);
-  //			setupDataRedirection(NCaps.Get (2), 1, now);
-  //			break;
-  //		case 3:
-  //			setupRedirection(NCcenters.Get (1), 1, now);
-  //			setupDataRedirection(NCaps.Get (3), 1, now);
-  //			break;
-  //		}
-  //
-  //		/////////////////////////////////////////////////////
-  //
-  //		/////////////////////////////////////////////////////
-  //	}
-  //cout << "Exiting apDeassociation!" << endl;
-  //cout << "%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%" << endl;
-}
-
-// Function to change the SSID of a Node, depending on distance
-void SetSSIDviaDistance(uint32_t mtId, Ptr<MobilityModel> node, std::map<std::string, Ptr<MobilityModel> > aps, bool smartInf)
+MobileHandoff::SetSSIDviaDistance (std::string ssid)
 {
   char configbuf[250];
   char configbuf2[250];
   char buffer[250];
 
-  // This causes the device in mtId to change the SSID, forcing AP change
-  sprintf(configbuf, "/NodeList/%d/DeviceList/0/$ns3::WifiNetDevice/Mac/Ssid", mtId);
+  // This causes the device in m_mtId to change the SSID, forcing AP change
+  sprintf(configbuf, "/NodeList/%d/DeviceList/0/$ns3::WifiNetDevice/Mac/Ssid", m_mtId);
 
-//  if (smartInf)
+//  if (m_smartInf)
 //    {
 //      sprintf(configbuf2, "/NodeList/%d/DeviceList/0/$ns3::WifiNetDevice/Mac/Ssid", 1);
 //    }
 
-  std::map<double, std::string> SsidDistance;
-
-  // Iterate through the map of seen Ssids
-  for (std::map<std::string, Ptr<MobilityModel> >::iterator ii=aps.begin(); ii!=aps.end(); ++ii)
-    {
-      // Calculate the distance from the AP to the node and save into the map
-      SsidDistance[node->GetDistanceFrom((*ii).second)] = (*ii).first;
-    }
-
-  double distance = SsidDistance.begin()->first;
-  std::string ssid(SsidDistance.begin()->second);
 
   // If the first time, no sector change
-  if (ssidOld.empty())
+  if (m_ssidOld.empty())
     {
-      ssidOld = ssid;
+      m_ssidOld = ssid;
     }
   else
     {
-      if (ssidOld.compare(ssid) != 0)
+      if (m_ssidOld.compare(ssid) != 0)
 	{
-	  sprintf(buffer, "We will have sector change from %s to %s", ssidOld.c_str(), ssid.c_str());
+	  sprintf(buffer, "We will have sector change from %s to %s", m_ssidOld.c_str(), ssid.c_str());
 	  NS_LOG_INFO(buffer);
 
-	  ssidOld = ssid;
-	  sectorChange = true;
-	  if (smartInf)
+	  if (m_smartInf)
 	    {
-
-	      numqueue = ssidToNum[ssid];
-	      if (numqueue == 1)
-		{
-		  // Central node
-		  setupRedirection(NCcenters.Get (0), 1, Simulator::Now());
-		  //setupDataRedirection(NCcenters.Get (0), 1, Simulator::Now());
-
-		  // AP node
-		  setupDataRedirection(NCaps.Get (1), 1, Simulator::Now());
-		}
-
-	      if (numqueue == 2)
-		{
-		  // Schedule changes
-		  // Server
-		  setupRedirection(NCservers.Get (0), 1, Simulator::Now());
-		  //setupDataRedirection(NCservers.Get (0), 1, Simulator::Now());
-
-		  // Central node
-		  setupDataRedirection(NCcenters.Get (1), 0, Simulator::Now());
-
-		  // Ap node
-		  setupDataRedirection(NCaps.Get (2), 1, Simulator::Now());
-		}
-
-	      if (numqueue == 3)
-		{
-		  // Central node
-		  setupRedirection(NCcenters.Get (1), 1, Simulator::Now());
-		  //setupDataRedirection(NCcenters.Get (1), 1, Simulator::Now());
-
-		  // Ap node
-		  setupDataRedirection(NCaps.Get (3), 1, Simulator::Now());
-		}
+	      m_handoffFrom = ssidToNode[m_ssidOld];
+	      setupHandoffRedirection (m_handoffFrom, ssidToNode[ssid]);
 	    }
+
+	  m_ssidOld = ssid;
+	  m_sectorChange = true;
 	}
     }
 
-  sprintf(buffer, "Change to SSID %s at distance of %f", ssid.c_str(), distance);
+  sprintf(buffer, "Change to SSID %s", ssid.c_str());
 
   NS_LOG_INFO(buffer);
   NS_LOG_INFO("Change at " << Simulator::Now() );
 
-  // Because the map sorts by std:less, the first position has the lowest distance
   Config::Set(configbuf, SsidValue(ssid));
 
-//  if (smartInf)
+//  if (m_smartInf)
 //    {
 //      Config::Set(configbuf2, SsidValue(ssid));
 //    }
-
-  // Empty the maps
-  SsidDistance.clear();
 }
 
 int main (int argc, char *argv[])
 {
   // These are our scenario arguments
-  uint32_t sectors = 2;                         // Number of wireless sectors
-  uint32_t aps = 2;					          // Number of wireless access nodes in a sector
   uint32_t mobile = 1;				          // Number of mobile terminals
   uint32_t servers = 1;				          // Number of servers in the network
-  uint32_t wnodes = aps * sectors;              // Number of nodes in the network
+  uint32_t wnodes = 0;                          // Number of wireless access nodes, set by the topology
+  std::string topologyFile;                     // Servers, central nodes and APs to build (empty for the default)
+  std::string hexFile;                          // Hexagon deployment from random/hexagon-random.py to build instead
   uint32_t xaxis = 300;                         // Size of the X axis
   uint32_t yaxis = 300;                         // Size of the Y axis
   double sec = 0.0;                             // Movement start
@@ -662,7 +955,21 @@ int main (int argc, char *argv[])
   int contentSize = -1;                         // Size of content to be retrieved
   int maxSeq = -1;                              // Maximum number of Data packets to request
   double retxtime = 0.05;                       // How frequent Interest retransmission timeouts should be checked (seconds)
+  bool predict = false;                         // Pre-push content to the AP the mobile is heading to
+  double lead = 0;                              // How far ahead to predict (seconds, 0 is one distance check)
   int csSize = 10000000;                        // How big the Content Store should be
+  int rcsSize = 0;                              // How big the redirected Data partition should be (0 for none)
+  int admitWindow = 0;                          // Sequence window admitted into the redirected Data partition
+  bool pace = false;                            // Hold Interests while the mobile is not associated
+  int contents = 0;                             // Number of content objects requested with Zipf popularity (0 for one)
+  double zipf = 0.8;                            // Zipf exponent of the content popularity
+  double avgSize = 1;                           // Average content object size in MB
+  bool window = false;                          // Let an AIMD window set the Interest rate instead of mbps
+  bool waste = false;                           // Count duplicate, late and unsolicited Data at the mobile
+  std::string record;                           // Where to record the Interest schedule of the first mobile
+  std::string replay;                           // Interest schedule the mobiles replay instead of running PriConsumer
+  bool hist = false;                            // Keep delay histograms in the consumers instead of per packet traces
+  double lease = 0;                             // How long redirection stays on without renewal (seconds, 0 for ever)
   //double deltaTime = 10;
   std::string nsTFile;                          // Name of the NS Trace file to use
   char nsTDir[250] = "./Waypoints";           // Directory for the waypoint files
@@ -671,8 +978,10 @@ int main (int argc, char *argv[])
   char buffer[250];
 
   CommandLine cmd;
-  cmd.AddValue ("mobile", "Number of mobile terminals in simulation", mobile);
+  cmd.AddValue ("mobile", "Number of mobile terminals in simulation, each needs its own trajectory in the trace", mobile);
   cmd.AddValue ("servers", "Number of servers in the simulation", servers);
+  cmd.AddValue ("topology", "File declaring the servers, central nodes, APs and links (default 1 server, 2 sectors of 2 APs)", topologyFile);
+  cmd.AddValue ("hex", "Build the hexagon deployment in this file, one sector per gateway (see random/hexagon-random.py)", hexFile);
   cmd.AddValue ("results", "Directory to place results", results);
   cmd.AddValue ("start", "Starting second", sec);
   cmd.AddValue ("fake", "Enable fake interest", fake);
@@ -681,6 +990,18 @@ int main (int argc, char *argv[])
   cmd.AddValue ("sinf", "Enable SmartFlooding with INF", smartInf);
   cmd.AddValue ("bestr", "Enable BestRoute forwarding", bestr);
   cmd.AddValue ("csSize", "Number of Interests a Content Store can maintain", csSize);
+  cmd.AddValue ("rcsSize", "Number of redirected Data kept apart from the Content Store (sinf only)", rcsSize);
+  cmd.AddValue ("admitWindow", "Sequence window admitted into the redirected Data store (0 for all)", admitWindow);
+  cmd.AddValue ("pace", "Hold Interests during handoffs and release them on reassociation", pace);
+  cmd.AddValue ("contents", "Number of content objects to request with Zipf popularity (0 for a single one)", contents);
+  cmd.AddValue ("zipf", "Zipf exponent of the content popularity", zipf);
+  cmd.AddValue ("avgSize", "Average content object size in MB, geometrically distributed", avgSize);
+  cmd.AddValue ("window", "Send Interests as an AIMD window allows instead of at the mbps rate", window);
+  cmd.AddValue ("waste", "Count duplicate, late and unsolicited Data reaching the mobile", waste);
+  cmd.AddValue ("record", "Record the Interests of the first mobile to this file", record);
+  cmd.AddValue ("replay", "Replay this recorded Interest schedule on every mobile", replay);
+  cmd.AddValue ("hist", "Write delay percentiles per window and handoff instead of one line per Data (needs trace)", hist);
+  cmd.AddValue ("lease", "Seconds redirection stays on if nothing turns it off (0 for ever)", lease);
   cmd.AddValue ("walk", "Enable random walk at walking speed", walk);
   cmd.AddValue ("speed", "Number of speed/hour of mobile terminals in the simulation", speed);
   cmd.AddValue ("endTime", "How long the simulation will last (Seconds)", endTime);
@@ -688,6 +1009,8 @@ int main (int argc, char *argv[])
   cmd.AddValue ("size", "Content size in MB (-1 is for no limit)", contentSize);
   cmd.AddValue ("retx", "How frequent Interest retransmission timeouts should be checked in seconds", retxtime);
   cmd.AddValue ("wifig", "Use Wifi G Standard", wifig);
+  cmd.AddValue ("predict", "Pre-push content to the next AP (needs sinf)", predict);
+  cmd.AddValue ("lead", "How far ahead to predict the next AP in seconds", lead);
   cmd.AddValue ("traceFile", "Directory containing Ns2 movement trace files (Usually created by Bonnmotion)", nsTDir);
   //cmd.AddValue ("deltaTime", "time interval (s) between updates (default 100)", deltaTime);
   cmd.Parse (argc,argv);
@@ -744,24 +1067,6 @@ int main (int argc, char *argv[])
   cout << "endtime=" << endTime << endl;
 
 
-  vector<double> centralXpos;
-  vector<double> centralYpos;
-  centralXpos.push_back(50.0);
-  centralXpos.push_back(250.0);
-  centralYpos.push_back(-50.0);
-  centralYpos.push_back(-50.0);
-
-  vector<double> wirelessXpos;
-  vector<double> wirelessYpos;
-  wirelessXpos.push_back(0);
-  wirelessXpos.push_back(100);
-  wirelessXpos.push_back(200);
-  wirelessXpos.push_back(300);
-  wirelessYpos.push_back(0);
-  wirelessYpos.push_back(0);
-  wirelessYpos.push_back(0);
-  wirelessYpos.push_back(0);
-
   // What the NDN Data packet payload size is fixed to 1024 bytes
   uint32_t payLoadsize = 1024;
 
@@ -790,24 +1095,40 @@ int main (int argc, char *argv[])
       NS_LOG_INFO(mobileTerminalContainer.Get (i)->GetId ());
     }
 
-  // Central Nodes
-  NodeContainer centralContainer;
-  centralContainer.Create (sectors);
+  // Central, wireless access and server nodes
+  if (!hexFile.empty ())
+    {
+      if (!topology.LoadHexagon (hexFile, servers))
+	NS_FATAL_ERROR (topology.GetError ());
+    }
+  else if (topologyFile.empty ())
+    {
+      topology.LoadDefault (servers);
+    }
+  else if (!topology.Load (topologyFile))
+    {
+      NS_FATAL_ERROR (topology.GetError ());
+    }
+
+  topology.Build ();
+
+  NodeContainer centralContainer = topology.GetCentrals ();
+  NodeContainer wirelessContainer = topology.GetAps ();
+  NodeContainer serverNodes = topology.GetServers ();
+
+  wnodes = wirelessContainer.GetN ();
+  servers = serverNodes.GetN ();
 
   std::vector<uint32_t> centralNodesIds;
 
   NS_LOG_INFO("------ Central Ids ------");
   // Save all the mobile Node IDs
-  for (int i = 0; i < sectors; i++)
+  for (int i = 0; i < centralContainer.GetN (); i++)
     {
       centralNodesIds.push_back(centralContainer.Get (i)->GetId ());
       NS_LOG_INFO(centralContainer.Get (i)->GetId ());
     }
 
-  // Wireless access Nodes
-  NodeContainer wirelessContainer;
-  wirelessContainer.Create (wnodes);
-
   std::vector<uint32_t> wirelessNodesIds;
 
   NS_LOG_INFO("------ Wireless Ids ------");
@@ -817,33 +1138,11 @@ int main (int argc, char *argv[])
       NS_LOG_INFO(wirelessContainer.Get (i)->GetId ());
     }
 
-  // Separate the wireless nodes into sector specific containers
-  std::vector<NodeContainer> sectorNodes;
-
-  for (int i = 0; i < sectors; i++)
-    {
-      NodeContainer wireless;
-      for (int j = i*aps; j < aps + i*aps; j++)
-	{
-	  wireless.Add(wirelessContainer.Get (j));
-	}
-      sectorNodes.push_back(wireless);
-    }
-
-  // Find out how many first level nodes we will have
-  // The +1 is for the server which will be attached to the first level nodes
-  int first = (sectors / 3) + 1;
-
-
   // Container for all NDN capable nodes
   NodeContainer allNdnNodes;
   allNdnNodes.Add (centralContainer);
   allNdnNodes.Add (wirelessContainer);
 
-  // Container for server (producer) nodes
-  NodeContainer serverNodes;
-  serverNodes.Create (servers);
-
   std::vector<uint32_t> serverNodeIds;
 
   NS_LOG_INFO("------ Server Ids ------");
@@ -866,60 +1165,9 @@ int main (int argc, char *argv[])
   NCmobiles = mobileTerminalContainer;
   NCservers = serverNodes;
 
-  // Container for each AP to be identified
-  NodeContainer SSID1;
-  SSID1.Add (wirelessContainer.Get(0));
-  NodeContainer SSID2;
-  SSID2.Add (wirelessContainer.Get(1));
-  NodeContainer SSID3;
-  SSID3.Add (wirelessContainer.Get(2));
-  NodeContainer SSID4;
-  SSID4.Add (wirelessContainer.Get(3));
-
   // Make sure to seed our random
   gen.seed (std::time (0) + (long long)getpid () << 32);
 
-  MobilityHelper Server;
-  Ptr<ListPositionAllocator> initialServer = CreateObject<ListPositionAllocator> ();
-
-  Vector posServer (150, -100, 0.0);
-  initialServer->Add (posServer);
-
-  Server.SetPositionAllocator(initialServer);
-  Server.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
-  Server.Install(serverNodes);
-
-  NS_LOG_INFO ("------Placing Central nodes-------");
-  MobilityHelper centralStations;
-
-  Ptr<ListPositionAllocator> initialCenter = CreateObject<ListPositionAllocator> ();
-
-  for (int i = 0; i < sectors; i++)
-    {
-      Vector pos (centralXpos[i], centralYpos[i], 0.0);
-      initialCenter->Add (pos);
-    }
-
-  centralStations.SetPositionAllocator(initialCenter);
-  centralStations.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
-  centralStations.Install(centralContainer);
-
-  NS_LOG_INFO ("------Placing wireless access nodes------");
-  MobilityHelper wirelessStations;
-
-  Ptr<ListPositionAllocator> initialWireless = CreateObject<ListPositionAllocator> ();
-
-  for (int i = 0; i < wnodes; i++)
-    {
-      Vector pos (wirelessXpos[i], wirelessYpos[i], 0.0);
-      initialWireless->Add (pos);
-    }
-
-  wirelessStations.SetPositionAllocator(initialWireless);
-  wirelessStations.SetMobilityModel("ns3::ConstantPositionMobilityModel");
-  wirelessStations.Install(wirelessContainer);
-
-
   NS_LOG_INFO ("------Placing mobile node and determining direction and speed------");
   MobilityHelper mobileStations;
 
@@ -934,6 +1182,15 @@ int main (int argc, char *argv[])
   Ns2MobilityHelper ns2 = Ns2MobilityHelper (nsTFile);
   ns2.Install ();
 
+  // The mobiles are the first nodes, so mobile i follows $node_(i) of the
+  // trace. Without one it would have neither a position nor handoffs
+  for (int i = 0; i < mobile; i++)
+    {
+      if (mobileTerminalContainer.Get (i)->GetObject<MobilityModel> () == 0)
+	NS_FATAL_ERROR ("The trace " << nsTFile << " has no movements for $node_(" << i
+			<< "), it needs one trajectory per mobile terminal");
+    }
+
 //  MobilityHelper mobile2;
 //  Ptr<ListPositionAllocator> initialMobile2 = CreateObject<ListPositionAllocator> ();
 //
@@ -944,36 +1201,6 @@ int main (int argc, char *argv[])
 //  mobile2.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
 //  mobile2.Install(mobileTerminalContainer.Get (1));
 
-  // Connect Wireless Nodes to central nodes
-  // Because the simulation is using Wifi, PtP connections are 100Mbps
-  // with 5ms delay
-  NS_LOG_INFO("------Connecting Central nodes to wireless access nodes------");
-
-  vector <NetDeviceContainer> ptpWLANCenterDevices;
-
-  PointToPointHelper p2p_100mbps5ms;
-  p2p_100mbps5ms.SetDeviceAttribute ("DataRate", StringValue ("100Mbps"));
-  p2p_100mbps5ms.SetChannelAttribute ("Delay", StringValue ("1ms"));
-
-  for (int i = 0; i < sectors; i++)
-    {
-      NetDeviceContainer ptpWirelessCenterDevices;
-
-      for (int j = 0; j < aps; j++)
-	{
-	  ptpWirelessCenterDevices.Add (p2p_100mbps5ms.Install (centralContainer.Get (i), sectorNodes[i].Get (j) ));
-	}
-
-      ptpWLANCenterDevices.push_back (ptpWirelessCenterDevices);
-    }
-
-  // Connect the server to central node
-  NetDeviceContainer ptpServerlowerNdnDevices;
-  for(int i =0; i < sectors; i++){
-      ptpServerlowerNdnDevices.Add (p2p_100mbps5ms.Install (serverNodes.Get (0), centralContainer.Get (i)));
-
-  }
-
   NS_LOG_INFO ("------Creating Wireless cards------");
 
   // Use the Wifi Helper to define the wireless interfaces for APs
@@ -1012,9 +1239,8 @@ int main (int argc, char *argv[])
 
   NS_LOG_INFO ("------Creating ssids for wireless cards------");
 
-  // We store the Wifi AP mobility models in a map, ordered by the ssid string. Will be easier to manage when
-  // calling the modified StaMApWifiMac
-  std::map<std::string, Ptr<MobilityModel> > apTerminalMobility;
+  // We index the Wifi AP positions by ssid, built once to find the closest AP to each mobile
+  ApGridIndex apTerminalMobility;
 
   for (int i = 0; i < wnodes +1; i++)
     {
@@ -1024,19 +1250,20 @@ int main (int argc, char *argv[])
       // Push the newly created SSID into a vector
       ssidV.push_back (Ssid (ssidtmp));
 
-      ssidToNode[ssidtmp] = wirelessContainer.Get (i);
-      ssidToNum[ssidtmp] = i;
-      numToNode[i] = wirelessContainer.Get (i);
-
       if (i < wnodes) {
+	  ssidToNode[ssidtmp] = wirelessContainer.Get (i);
+	  numToNode[i] = wirelessContainer.Get (i);
+
 	  // Get the mobility model for wnode i
 	  Ptr<MobilityModel> tmp = (wirelessContainer.Get (i))->GetObject<MobilityModel> ();
 
-	  // Store the information into our map
-	  apTerminalMobility[ssidtmp] = tmp;
+	  // Store the information into our index
+	  apTerminalMobility.Add (ssidtmp, tmp->GetPosition ());
       }
     }
 
+  apTerminalMobility.Build ();
+
   NS_LOG_INFO ("------Assigning mobile terminal wireless cards------");
 
   NS_LOG_INFO ("Assigning AP wireless cards");
@@ -1064,9 +1291,7 @@ int main (int argc, char *argv[])
 
   /////////////////////////////////////////////////////
 
-  mobileDevices.push_back(wifi.Install(wifiPhyHelper, wifiMacHelper, mobileTerminalContainer.Get (0)));
-
-  //mobileDevices.push_back(wifi.Install(wifiPhyHelper, wifiMacHelper, mobileTerminalContainer.Get (1)));
+  mobileDevices.push_back(wifi.Install(wifiPhyHelper, wifiMacHelper, mobileTerminalContainer));
 
   // Using the same calculation from the Yans-wifi-Channel, we obtain the Mobility Models for the
   // mobile node as well as all the Wifi capable nodes
@@ -1099,7 +1324,10 @@ int main (int argc, char *argv[])
   } else if (smartInf) {
       sprintf(routeType, "%s", "smartinf");
       NS_LOG_INFO ("NDN Utilizing SmartFlooding with INF");
-      ndnHelperRouters.SetForwardingStrategy ("ns3::ndn::fw::SmartFloodingInf");
+      ndnHelperRouters.SetForwardingStrategy ("ns3::ndn::fw::SmartFloodingInf",
+					      "RedirectStoreSize", boost::lexical_cast<std::string> (rcsSize),
+					      "RedirectAdmitWindow", boost::lexical_cast<std::string> (admitWindow),
+					      "RedirectLease", boost::lexical_cast<std::string> (lease) + "s");
   } else {
       sprintf(routeType, "%s", "flood");
       NS_LOG_INFO ("NDN Utilizing Flooding");
@@ -1169,10 +1397,48 @@ int main (int argc, char *argv[])
   consumerHelper.SetAttribute ("StartTime", TimeValue (Seconds(1)));
   consumerHelper.SetAttribute ("StopTime", TimeValue (Seconds (endTime+5)));
   consumerHelper.SetAttribute ("RetxTimer", TimeValue (Seconds(retxtime)));
+  consumerHelper.SetAttribute ("HandoffPacing", BooleanValue (pace));
+  consumerHelper.SetAttribute ("WindowControl", BooleanValue (window));
+  consumerHelper.SetAttribute ("CountDeliveries", BooleanValue (waste));
   if (maxSeq > 0)
     consumerHelper.SetAttribute ("MaxSeq", IntegerValue(maxSeq));
+  if (contents > 0)
+    {
+      // Each content object sets its own MaxSeq
+      consumerHelper.SetAttribute ("Contents", UintegerValue (contents));
+      consumerHelper.SetAttribute ("ZipfAlpha", DoubleValue (zipf));
+      consumerHelper.SetAttribute ("AvgContentSize", DoubleValue (avgSize));
+      consumerHelper.SetAttribute ("ChunkSize", UintegerValue (payLoadsize));
+    }
+
+  if (replay.empty ())
+    {
+      // With several mobiles each one asks for its own names, so the
+      // redirection set up for one mobile leaves the Data of the others alone
+      for (int i = 0; i < mobileTerminalContainer.GetN (); i++)
+	{
+	  if (mobile > 1)
+	    consumerHelper.SetPrefix (mobilePrefix (mobileTerminalContainer.Get (i)));
+
+	  consumerHelper.Install (mobileTerminalContainer.Get (i));
+	}
+
+      consumerHelper.SetPrefix ("/waseda/sato");
+    }
+  else
+    {
+      // The same Interests at the same times whatever the forwarding strategy
+      ndn::AppHelper replayHelper ("ns3::ndn::ReplayConsumer");
+      replayHelper.SetAttribute ("ScheduleFile", StringValue (replay));
+      replayHelper.SetAttribute ("StartTime", TimeValue (Seconds(1)));
+      replayHelper.SetAttribute ("StopTime", TimeValue (Seconds (endTime+5)));
+      replayHelper.Install (mobileTerminalContainer);
+    }
+
+  if (!record.empty () && replay.empty ())
+    Config::Set ("/NodeList/" + boost::lexical_cast<string> (mobileTerminalContainer.Get (0)->GetId ()) + "/ApplicationList/*/$ns3::ndn::PriConsumer/RecordFile",
+		 StringValue (record));
 
-  consumerHelper.Install (mobileTerminalContainer);
   if(fake)	consumerHelper.Install (centralContainer);			//change here (normal / fake interest)
 
   sprintf(buffer, "Ending time! %f", endTime+5);
@@ -1235,8 +1501,34 @@ int main (int argc, char *argv[])
       ndn::L3RateTracer::InstallAll (filename, Seconds (1.0));
 
       // NDN App Tracer
-      sprintf (filename, "%s/%s/%s/%.0f/app-delays-%s-%d", results, scenario, mode, speed, routeType, text);
-      ndn::AppDelayTracer::InstallAll (filename);
+      if (hist)
+	{
+	  // One summary file per mobile, written when its consumer stops
+	  for (int i = 0; i < mobileTerminalContainer.GetN (); i++)
+	    {
+	      uint32_t id = mobileTerminalContainer.Get (i)->GetId ();
+	      sprintf (filename, "%s/%s/%s/%.0f/app-hist-%s-%d-%d", results, scenario, mode, speed, routeType, text, id);
+	      Config::Set ("/NodeList/" + boost::lexical_cast<string> (id) + "/ApplicationList/*/$ns3::ndn::PriConsumer/HistogramFile",
+			   StringValue (filename));
+	    }
+	}
+      else
+	{
+	  sprintf (filename, "%s/%s/%s/%.0f/app-delays-%s-%d", results, scenario, mode, speed, routeType, text);
+	  ndn::AppDelayTracer::InstallAll (filename);
+	}
+
+      // SmartFloodingInf buffer flush tracer
+      if (smartInf)
+	{
+	  sprintf (filename, "%s/%s/%s/%.0f/flush-trace-%s-%d", results, scenario, mode, speed, routeType, text);
+	  AsciiTraceHelper asciiTraceHelper;
+	  Ptr<OutputStreamWrapper> flushStream = asciiTraceHelper.CreateFileStream (filename);
+	  *flushStream->GetStream () << "Time\tNode\tFace\tBacklog\tSent\tDropped\tSkipped\tDuration" << endl;
+
+	  Config::ConnectWithoutContext ("/NodeList/*/$ns3::ndn::ForwardingStrategy/$ns3::ndn::fw::SmartFloodingInf/FlushEnd",
+					 MakeBoundCallback (&FlushEndTrace, flushStream));
+	}
 
       // L2 Drop rate tracer
       //		sprintf (filename, "%s/%s/%s/%.0f/drop-trace", results, scenario, mode, speed);
@@ -1247,143 +1539,116 @@ int main (int argc, char *argv[])
       //		ndn::CsTracer::InstallAll (filename, Seconds (1));
   }
 
-  // Get the Consumer application
-  Ptr<PriConsumer> consumer = DynamicCast<PriConsumer> (mobileTerminalContainer.Get (0)->GetApplication(0));
+  // Get the Consumer application of every mobile, none when replaying
+  std::vector<Ptr<PriConsumer> > consumers;
+  for (int i = 0; i < mobileTerminalContainer.GetN (); i++)
+    {
+      Ptr<PriConsumer> consumer = DynamicCast<PriConsumer> (mobileTerminalContainer.Get (i)->GetApplication(0));
+      if (consumer != 0)
+	consumers.push_back (consumer);
+    }
 
   NS_LOG_INFO ("------Scheduling events - SSID changes------");
 
+  // Schedule AP Changes
+  double apsec = 0.0;
+  // Time to cross between two APs 100m apart, the default pre-push lead
+  double checkTime = 100.0/realspeed;
+  if (lead <= 0)
+    lead = checkTime;
+
+  // Stop the application from generating more things without actually dying
+  for (uint32_t i = 0; i < consumers.size (); i++)
+    Simulator::Schedule (Seconds (endTime), &PriConsumer::StopTraffic, consumers[i]);
+
+  // Hand each mobile to the closest AP whenever its trajectory crosses into
+  // another AP's area
+  std::vector<Ptr<MobileHandoff> > mobileHandoffs;
+  std::vector<Ptr<HandoffScheduler> > handoffSchedulers;
   char configbuf[250];
 
   for (int i = 0; i < mobileTerminalContainer.GetN (); i++)
     {
+      uint32_t nodeId = mobileTerminalContainer.Get (i)->GetId();
+
+      // A single mobile keeps the shared rules on the whole namespace.
+      // Consumer 0 is the shared one, so the ids start at 1
+      Ptr<MobileHandoff> state;
+      if (mobile > 1 && replay.empty ())
+	state = Create<MobileHandoff> (nodeId, smartInf, Name (mobilePrefix (mobileTerminalContainer.Get (i))), nodeId + 1);
+      else
+	state = Create<MobileHandoff> (nodeId, smartInf, Name ("/"), 0);
 
       if (smartInf)
 	{
 	  // When associating
-	  sprintf(configbuf, "/NodeList/%d/DeviceList/%d/$ns3::WifiNetDevice/Mac/$ns3::StaWifiMac/Assoc", mobileTerminalContainer.Get (i)->GetId(), 0);
+	  sprintf(configbuf, "/NodeList/%d/DeviceList/%d/$ns3::WifiNetDevice/Mac/$ns3::StaWifiMac/Assoc", nodeId, 0);
 	  // Connect to the tracing
-	  Config::ConnectWithoutContext(configbuf, MakeCallback(&apAssociation));
-
-	  // When disassociating
-	  sprintf(configbuf, "/NodeList/%d/DeviceList/%d/$ns3::WifiNetDevice/Mac/$ns3::StaWifiMac/DeAssoc", mobileTerminalContainer.Get (i)->GetId(), 0);
-	  // Connect to the tracing
-	  Config::ConnectWithoutContext(configbuf, MakeCallback(&apDeassociation));
+	  Config::ConnectWithoutContext(configbuf, MakeCallback(&MobileHandoff::apAssociation, state));
 	}
+
+      Ptr<HandoffScheduler> handoff = Create<HandoffScheduler> (mobileTerminalsMobility[i], &apTerminalMobility);
+
+      handoff->SetHandoffCallback (MakeCallback (&MobileHandoff::SetSSIDviaDistance, state));
+
+      if (smartInf && predict)
+	handoff->SetPrepushCallback (MakeCallback (&MobileHandoff::PredictHandoff, state), Seconds (lead));
+
+      Simulator::Schedule (Seconds (apsec), &HandoffScheduler::Start, handoff);
+      Simulator::Schedule (Seconds (endTime), &HandoffScheduler::Stop, handoff);
+      mobileHandoffs.push_back (state);
+      handoffSchedulers.push_back (handoff);
     }
 
-  // Schedule AP Changes
-  double apsec = 0.0;
-  // How often should the AP check it's distance
-  double checkTime = 100.0/realspeed;
-  // How often should we check the timeouts (milliseconds)
-  double totalCheckTime = 1000;
-  double timeTime = 5;
-  double tmpT = 0;
+  NS_LOG_INFO ("------Ready for execution!------");
 
-  // Stop the application from generating more things without actually dying
-  Simulator::Schedule(Seconds(endTime), &Config::Set, "/NodeList/"+boost::lexical_cast<string> (mobileTerminalContainer.Get (0)->GetId())+"/ApplicationList/*/$ns3::ndn::ConsumerCbr/Frequency",
-               DoubleValue(0.1));
+  if (contents > 0)
+    WatchCaches (allNdnNodes);
 
-  double j = apsec;
-  int k = 0;
+  // Past the StopTime of the applications, so they get to stop
+  Simulator::Stop (Seconds (endTime+6));
+  Simulator::Run ();
 
-  while ( j < endTime)
+  for (uint32_t i = 0; i < consumers.size (); i++)
     {
-      for (int i = 0; i < 1; i++)
-	{
-	  sprintf(buffer, "Running event SSID distance event at %f for node ", j);
-	  NS_LOG_INFO(buffer);
+      Ptr<PriConsumer> consumer = consumers[i];
 
-	  uint32_t nodeId = mobileTerminalContainer[i]->GetId();
-	  Simulator::Schedule (Seconds(j), &SetSSIDviaDistance, nodeId, mobileTerminalsMobility[i], apTerminalMobility, smartInf);
-	}
+      // With several mobiles, say whose figures follow
+      if (consumers.size () > 1 && (waste || window || contents > 0 || pace))
+	cout << "Node " << consumer->GetNode ()->GetId () << endl;
 
+      if (waste)
+	PrintDeliveries (consumer);
 
-      //		Time torun = Seconds(j);
-      //		Time denPush = torun - MilliSeconds(10);
-
-
-      //		for (int i = 0; i < mobile && k <= 3; i++)
-      //		{
-      //			Time ssi = torun;
-      //
-      //			cout << "Scheduling SSID change for mobile node " << i << " at " << torun << endl;
-      //
-      //			/////////////////////////////////////////////////////
-      //
-      //			/////////////////////////////////////////////////////
-      ////
-      ////			if (k > 0)
-      ////			{
-      ////				ssi -= MilliSeconds(10);
-      ////				Simulator::Schedule(torun, &SetSSID, mobileNodeIds[i], k-1, ssidV[wnodes]);
-      ////			}
-      ////			Simulator::Schedule (ssi, &SetSSID, mobileNodeIds[i], k, ssidV[k]);
-      //
-      //			/////////////////////////////////////////////////////
-      //			Simulator::Schedule (ssi, &SetSSID, mobileNodeIds[i], 0, ssidV[k]);
-      //
-      //		}
-
-      //		if (smartInf) {
-      //
-      //			Ptr<Node> tmp;
-      //			Ptr<Node> tmp2;
-      //			if (k == 1)
-      //			{
-      //				cout << "K = 1 Scheduling for " << denPush << endl;
-      //				// Central node
-      //				Simulator::Schedule (denPush, &setupRedirection, NCcenters.Get (0), 1, torun);
-      //				// AP node
-      //				Simulator::Schedule (denPush, &setupDataRedirection, NCaps.Get (1), 1, torun);
-      //			}
-      //
-      //			if (k == 2)
-      //			{
-      //				cout << "K = 2 Scheduling for " <<  denPush << endl;
-      //				// Schedule changes
-      //				// Server
-      //				Simulator::Schedule (denPush, &setupRedirection, serverNodes.Get (0), 1, torun);
-      //
-      //				// Central node
-      //				Simulator::Schedule (denPush, &setupDataRedirection, centralContainer.Get (1), 0, torun);
-      //
-      //				// Ap node
-      //				Simulator::Schedule (denPush, &setupDataRedirection, wirelessContainer.Get (2), 1, torun);
-      //			}
-      //
-      //			if (k == 3)
-      //			{
-      //				cout << "K = 3 Scheduling for " <<  denPush << endl;
-      //				// Central node
-      //				Simulator::Schedule (denPush, &setupRedirection, centralContainer.Get (1), 1, torun);
-      //
-      //				// Ap node
-      //				Simulator::Schedule (denPush, &setupDataRedirection, wirelessContainer.Get (3), 1, torun);
-      //			}
-      //		}
-
-      //		while (tmpT <= totalCheckTime && k > 0 && k <= 3)
-      //		{
-      //			Time tosche = torun + MilliSeconds(tmpT);
-      //			cout << "Running packet sequence event at " << tosche << endl;
-      //			//Simulator::Schedule (tosche, &PrintSeqs, consumer);
-      //			Simulator::Schedule (tosche, &INFObtained, centralContainer.Get (1), 2);
-      //			tmpT += timeTime;
-      //		}
-      //
-      //		NS_LOG_INFO ("------Testing PIT printing------");
-      //Simulator::Schedule (Seconds(j), &PeriodicPitPrinter, wirelessContainer.Get(0));
-      //	    Simulator::Schedule (Seconds(j), &PITEntryCreator, wirelessContainer.Get(k), wirelessContainer.Get(k+1));
-      j += checkTime;
-      tmpT = 0;
-      k++;
+      if (window)
+	cout << "Final window " << consumer->GetWindow () << endl;
+
+      if (contents > 0)
+	cout << "Contents completed " << consumer->GetCompletedContents ()
+	    << ", late Data " << consumer->GetStaleData () << endl;
+
+      if (pace)
+	cout << "Interests saved during handoffs " << consumer->GetSavedInterests ()
+	    << ", released on reassociation " << consumer->GetReleasedInterests () << endl;
     }
 
-  NS_LOG_INFO ("------Ready for execution!------");
+  if (contents > 0)
+    PrintCacheStats (allNdnNodes);
+
+  if (smartInf && predict)
+    PrintPrepushStats (wirelessContainer);
+
+  if (smartInf && rcsSize > 0)
+    PrintStoreStats (allNdnNodes);
+
+  if (!replay.empty ())
+    for (uint32_t i = 0; i < mobileTerminalContainer.GetN (); i++)
+      {
+	Ptr<ReplayConsumer> replayer = DynamicCast<ReplayConsumer> (mobileTerminalContainer.Get (i)->GetApplication (0));
+	cout << "Node " << mobileTerminalContainer.Get (i)->GetId () << " replayed " << replayer->GetSent ()
+	    << " Interests, abandoned " << replayer->GetAbandoned () << endl;
+      }
 
-  Simulator::Stop (Seconds (endTime+5));
-  Simulator::Run ();
   Simulator::Destroy ();
 
   NS_LOG_INFO ("End");